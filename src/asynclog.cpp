@@ -0,0 +1,144 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "asynclog.h"
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define ASYNCLOG_FLUSH_INTERVAL_MS	250
+#define ASYNCLOG_LINE_LENGTH		512
+
+AsyncLogEntry g_AsyncLogRing[ASYNCLOG_RING_SIZE];
+std::atomic<uint32_t> g_nAsyncLogHead(0);
+std::atomic<uint32_t> g_nAsyncLogTail(0);
+uint32_t g_nAsyncLogDropped = 0;
+
+static std::thread s_Thread;
+static std::atomic<bool> s_bRunning(false);
+static std::string s_Path;
+static std::string s_Tag;
+
+// Repeated line waiting for its count
+static char s_szLast[ASYNCLOG_LINE_LENGTH];
+static time_t s_nLastTime = 0;
+static uint32_t s_nLastRepeats = 0;
+static uint32_t s_nLastDropped = 0;
+
+static void WriteLine(FILE *pFile, time_t nTime, const char *pszMessage, uint32_t nRepeats)
+{
+	char szDate[32];
+	strftime(szDate, sizeof(szDate), "%m/%d/%Y - %H:%M:%S", localtime(&nTime));
+
+	if(nRepeats > 1)
+		fprintf(pFile, "L %s: [%s] %s (x%u)\n", szDate, s_Tag.c_str(), pszMessage, nRepeats);
+	else
+		fprintf(pFile, "L %s: [%s] %s\n", szDate, s_Tag.c_str(), pszMessage);
+}
+
+static void Flush()
+{
+	uint32_t tail = g_nAsyncLogTail.load(std::memory_order_relaxed);
+	uint32_t head = g_nAsyncLogHead.load(std::memory_order_acquire);
+	if(tail == head && !s_nLastRepeats)
+		return;
+
+	FILE *pFile = fopen(s_Path.c_str(), "a");
+
+	char szLine[ASYNCLOG_LINE_LENGTH];
+	for(; tail != head; tail++)
+	{
+		AsyncLogEntry *pEntry = &g_AsyncLogRing[tail & (ASYNCLOG_RING_SIZE - 1)];
+		pEntry->pfnFormat(szLine, sizeof(szLine), pEntry->pszFormat, pEntry->args);
+
+		if(s_nLastRepeats && strcmp(szLine, s_szLast) == 0)
+		{
+			s_nLastRepeats++;
+			continue;
+		}
+
+		if(s_nLastRepeats && pFile)
+			WriteLine(pFile, s_nLastTime, s_szLast, s_nLastRepeats);
+
+		memcpy(s_szLast, szLine, sizeof(s_szLast));
+		s_nLastTime = pEntry->nTime;
+		s_nLastRepeats = 1;
+	}
+	g_nAsyncLogTail.store(tail, std::memory_order_release);
+
+	// A batch ends the run of repeats, a message spread over two flushes is counted twice at worst
+	if(s_nLastRepeats && pFile)
+		WriteLine(pFile, s_nLastTime, s_szLast, s_nLastRepeats);
+	s_nLastRepeats = 0;
+
+	uint32_t nDropped = g_nAsyncLogDropped;
+	if(nDropped != s_nLastDropped && pFile)
+	{
+		snprintf(szLine, sizeof(szLine), "Log ring full, dropped %u messages", nDropped - s_nLastDropped);
+		WriteLine(pFile, time(NULL), szLine, 1);
+		s_nLastDropped = nDropped;
+	}
+
+	if(pFile)
+		fclose(pFile);
+}
+
+static void ThreadMain()
+{
+	while(s_bRunning.load(std::memory_order_relaxed))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(ASYNCLOG_FLUSH_INTERVAL_MS));
+		Flush();
+	}
+	Flush();
+}
+
+bool AsyncLog_Start(const char *pszPath, const char *pszTag)
+{
+	if(s_bRunning)
+		return true;
+
+	s_Path = pszPath;
+	s_Tag = pszTag;
+	s_bRunning = true;
+	s_Thread = std::thread(ThreadMain);
+	return true;
+}
+
+void AsyncLog_Stop()
+{
+	if(!s_bRunning)
+		return;
+
+	s_bRunning = false;
+	s_Thread.join();
+}
@@ -0,0 +1,211 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_ASYNCLOG_H_
+#define _INCLUDE_CSSFIXES_ASYNCLOG_H_
+
+/**
+ * @file asynclog.h
+ * @brief Logging off the game thread.
+ *
+ * AsyncLog() only copies the format pointer and its arguments into a single
+ * producer ring buffer, formatting and file I/O happen on a background thread
+ * which flushes in batches and collapses repeated lines into "(xN)".
+ *
+ * Only call it from the game thread. The format and any string arguments are
+ * read later, so they have to be string literals (or otherwise outlive the
+ * extension), short strings that don't can be passed as AsyncLogString.
+ * When the ring is full messages are dropped and counted.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+
+#define ASYNCLOG_RING_SIZE		1024	// power of two
+#define ASYNCLOG_ARG_BYTES		32
+
+// Copied into the entry by value, formatted as %s
+struct AsyncLogString
+{
+	char sz[20];
+};
+
+template <typename T>
+static inline T AsyncLog_Arg(const T &arg)
+{
+	return arg;
+}
+
+static inline const char *AsyncLog_Arg(const AsyncLogString &arg)
+{
+	return arg.sz;
+}
+
+typedef void (*AsyncLogFormatFn)(char *buffer, size_t maxlength, const char *pszFormat, const unsigned char *pArgs);
+
+struct AsyncLogEntry
+{
+	const char *pszFormat;
+	AsyncLogFormatFn pfnFormat;
+	time_t nTime;
+	unsigned char args[ASYNCLOG_ARG_BYTES];
+};
+
+extern AsyncLogEntry g_AsyncLogRing[ASYNCLOG_RING_SIZE];
+extern std::atomic<uint32_t> g_nAsyncLogHead;	// written by the producer
+extern std::atomic<uint32_t> g_nAsyncLogTail;	// written by the flush thread
+extern uint32_t g_nAsyncLogDropped;
+
+bool AsyncLog_Start(const char *pszPath, const char *pszTag);
+// Flushes everything still queued before returning
+void AsyncLog_Stop();
+
+// Every message goes through here, so "%%" works with and without arguments
+static inline void AsyncLog_VFormat(char *buffer, size_t maxlength, const char *pszFormat, ...)
+{
+	va_list ap;
+	va_start(ap, pszFormat);
+	vsnprintf(buffer, maxlength, pszFormat, ap);
+	va_end(ap);
+}
+
+static inline void AsyncLog_Format0(char *buffer, size_t maxlength, const char *pszFormat, const unsigned char *pArgs)
+{
+	AsyncLog_VFormat(buffer, maxlength, pszFormat);
+}
+
+template <typename A>
+static void AsyncLog_Format1(char *buffer, size_t maxlength, const char *pszFormat, const unsigned char *pArgs)
+{
+	A a;
+	memcpy(&a, pArgs, sizeof(A));
+	AsyncLog_VFormat(buffer, maxlength, pszFormat, AsyncLog_Arg(a));
+}
+
+template <typename A, typename B>
+static void AsyncLog_Format2(char *buffer, size_t maxlength, const char *pszFormat, const unsigned char *pArgs)
+{
+	A a; B b;
+	memcpy(&a, pArgs, sizeof(A));
+	memcpy(&b, pArgs + sizeof(A), sizeof(B));
+	AsyncLog_VFormat(buffer, maxlength, pszFormat, AsyncLog_Arg(a), AsyncLog_Arg(b));
+}
+
+template <typename A, typename B, typename C>
+static void AsyncLog_Format3(char *buffer, size_t maxlength, const char *pszFormat, const unsigned char *pArgs)
+{
+	A a; B b; C c;
+	memcpy(&a, pArgs, sizeof(A));
+	memcpy(&b, pArgs + sizeof(A), sizeof(B));
+	memcpy(&c, pArgs + sizeof(A) + sizeof(B), sizeof(C));
+	AsyncLog_VFormat(buffer, maxlength, pszFormat, AsyncLog_Arg(a), AsyncLog_Arg(b), AsyncLog_Arg(c));
+}
+
+static inline AsyncLogEntry *AsyncLog_Reserve()
+{
+	uint32_t head = g_nAsyncLogHead.load(std::memory_order_relaxed);
+	if(head - g_nAsyncLogTail.load(std::memory_order_acquire) >= ASYNCLOG_RING_SIZE)
+	{
+		g_nAsyncLogDropped++;
+		return NULL;
+	}
+
+	AsyncLogEntry *pEntry = &g_AsyncLogRing[head & (ASYNCLOG_RING_SIZE - 1)];
+	pEntry->nTime = time(NULL);
+	return pEntry;
+}
+
+static inline void AsyncLog_Commit()
+{
+	g_nAsyncLogHead.store(g_nAsyncLogHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+static inline void AsyncLog(const char *pszFormat)
+{
+	AsyncLogEntry *pEntry = AsyncLog_Reserve();
+	if(!pEntry)
+		return;
+
+	pEntry->pszFormat = pszFormat;
+	pEntry->pfnFormat = AsyncLog_Format0;
+	AsyncLog_Commit();
+}
+
+template <typename A>
+static inline void AsyncLog(const char *pszFormat, A a)
+{
+	static_assert(sizeof(A) <= ASYNCLOG_ARG_BYTES, "AsyncLog arguments too large");
+	AsyncLogEntry *pEntry = AsyncLog_Reserve();
+	if(!pEntry)
+		return;
+
+	pEntry->pszFormat = pszFormat;
+	pEntry->pfnFormat = AsyncLog_Format1<A>;
+	memcpy(pEntry->args, &a, sizeof(A));
+	AsyncLog_Commit();
+}
+
+template <typename A, typename B>
+static inline void AsyncLog(const char *pszFormat, A a, B b)
+{
+	static_assert(sizeof(A) + sizeof(B) <= ASYNCLOG_ARG_BYTES, "AsyncLog arguments too large");
+	AsyncLogEntry *pEntry = AsyncLog_Reserve();
+	if(!pEntry)
+		return;
+
+	pEntry->pszFormat = pszFormat;
+	pEntry->pfnFormat = AsyncLog_Format2<A, B>;
+	memcpy(pEntry->args, &a, sizeof(A));
+	memcpy(pEntry->args + sizeof(A), &b, sizeof(B));
+	AsyncLog_Commit();
+}
+
+template <typename A, typename B, typename C>
+static inline void AsyncLog(const char *pszFormat, A a, B b, C c)
+{
+	static_assert(sizeof(A) + sizeof(B) + sizeof(C) <= ASYNCLOG_ARG_BYTES, "AsyncLog arguments too large");
+	AsyncLogEntry *pEntry = AsyncLog_Reserve();
+	if(!pEntry)
+		return;
+
+	pEntry->pszFormat = pszFormat;
+	pEntry->pfnFormat = AsyncLog_Format3<A, B, C>;
+	memcpy(pEntry->args, &a, sizeof(A));
+	memcpy(pEntry->args + sizeof(A), &b, sizeof(B));
+	memcpy(pEntry->args + sizeof(A) + sizeof(B), &c, sizeof(C));
+	AsyncLog_Commit();
+}
+
+#endif // _INCLUDE_CSSFIXES_ASYNCLOG_H_
@@ -0,0 +1,1264 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+/**
+ * @file bench.cpp
+ * @brief Microbenchmarks for the extension's scanning and parsing primitives.
+ *
+ * Every result is printed as one JSON object per line:
+ * {"name": ..., "iterations": ..., "ns_per_op": ..., "ops_per_sec": ..., "bytes_per_sec": ...}
+ *
+ * Besides the primitives it replays synthetic server workloads through the
+ * detour logic in utils.h (spawn stream, bullet storm, context filters) and
+ * checks the results before timing them, the same tick event coalescing of a
+ * ZE round start and the packet rate limiter against a synthetic flood.
+ *
+ * With --replay it feeds captured map spawn streams (sv_cssfixes_spawncapture)
+ * through the same KeyValue/PostConstructor logic instead.
+ *
+ * Usage: CSSFixes.bench [filter] [min seconds per benchmark]
+ *        CSSFixes.bench --replay <cssfixes_spawns_*.cskv>...
+ */
+
+#include "utils.h"
+#include "coalesce.h"
+#include "ratelimit.h"
+#include "kvrules.h"
+#include "hudmsg.h"
+#include "cmdqueue.h"
+#include "teleport.h"
+#include "iotracer.h"
+#define SPAWNCAPTURE_READER_ONLY
+#include "spawncapture.h"
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+
+static const char *g_pszFilter = NULL;
+static double g_flMinSeconds = 0.25;
+static volatile uintptr_t g_Sink = 0;
+
+// Runs fn in batches until g_flMinSeconds have passed, bytesPerOp = 0 omits throughput in bytes
+template <typename F>
+static void Run(const std::string &name, size_t bytesPerOp, F fn)
+{
+	if(g_pszFilter && name.find(g_pszFilter) == std::string::npos)
+		return;
+
+	typedef std::chrono::steady_clock Clock;
+
+	// Warm up caches and branch predictors
+	for(int i = 0; i < 16; i++)
+		g_Sink += fn();
+
+	uint64_t iterations = 0;
+	uint64_t batch = 1;
+	double elapsed = 0.0;
+	Clock::time_point start = Clock::now();
+	while(elapsed < g_flMinSeconds)
+	{
+		for(uint64_t i = 0; i < batch; i++)
+			g_Sink += fn();
+
+		iterations += batch;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		if(batch < (1 << 20))
+			batch *= 2;
+	}
+
+	double nsPerOp = elapsed * 1e9 / iterations;
+	printf("{\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f",
+		name.c_str(), (unsigned long long)iterations, nsPerOp, iterations / elapsed);
+	if(bytesPerOp)
+		printf(", \"bytes_per_sec\": %.1f", (double)bytesPerOp * iterations / elapsed);
+	printf("}\n");
+	fflush(stdout);
+}
+
+static std::mt19937 g_Random(1337);
+
+static std::vector<unsigned char> RandomCode(size_t size)
+{
+	std::vector<unsigned char> code(size + 64);
+	for(size_t i = 0; i < code.size(); i++)
+		code[i] = (unsigned char)g_Random();
+	return code;
+}
+
+static void BenchFindPattern()
+{
+	// Patch 0 (CGameUI::Think) signature
+	static const unsigned char signature[] = "\x0F\x82\xC4\x03\x00\x00\x83\xEC\x08\x6A\x10\x53\xE8\x91\x00\xF5\xFF";
+	static const char pattern[] = "xx????xx?x?xx????";
+
+	static const size_t ranges[] = { 0x400, 0x800, 0x10000 };
+	for(size_t r = 0; r < sizeof(ranges) / sizeof(*ranges); r++)
+	{
+		size_t range = ranges[r];
+		std::vector<unsigned char> code = RandomCode(range);
+
+		// Plant the signature near the end so the whole range gets scanned
+		size_t at = range - sizeof(pattern);
+		memcpy(&code[at], signature, sizeof(pattern) - 1);
+
+		char name[64];
+		snprintf(name, sizeof(name), "FindPattern/planted/range=%zu", range);
+		Run(name, at, [&]() {
+			return FindPattern((uintptr_t)code.data(), signature, pattern, range);
+		});
+
+		// Worst case, scan the whole range and fail
+		code[at] ^= 0xFF;
+		snprintf(name, sizeof(name), "FindPattern/missing/range=%zu", range);
+		Run(name, range, [&]() {
+			return FindPattern((uintptr_t)code.data(), signature, pattern, range);
+		});
+	}
+}
+
+static void BenchFindFunctionCall()
+{
+	static const size_t ranges[] = { 0x7d1, 0x800, 0x10000 };
+	for(size_t r = 0; r < sizeof(ranges) / sizeof(*ranges); r++)
+	{
+		size_t range = ranges[r];
+		std::vector<unsigned char> code = RandomCode(range);
+
+		// Sprinkle calls to other functions, like real code
+		for(size_t i = 0; i + 5 < range; i += 16 + g_Random() % 32)
+			code[i] = 0xE8;
+
+		// Plant a call to the target near the end
+		size_t at = range - 16;
+		uintptr_t target = (uintptr_t)code.data() + 0x1000000;
+		int32_t rel = (int32_t)(target - ((uintptr_t)&code[at] + 5));
+		code[at] = 0xE8;
+		memcpy(&code[at + 1], &rel, sizeof(rel));
+
+		char name[64];
+		snprintf(name, sizeof(name), "FindFunctionCall/planted/range=%zu", range);
+		Run(name, at, [&]() {
+			return FindFunctionCall((uintptr_t)code.data(), target, range);
+		});
+
+		snprintf(name, sizeof(name), "FindFunctionCall/missing/range=%zu", range);
+		Run(name, range, [&]() {
+			return FindFunctionCall((uintptr_t)code.data(), target + 1, range);
+		});
+	}
+}
+
+static void BenchStringToVector()
+{
+	// absvelocity values as they show up in map entity lumps and AddOutput
+	static const char *values[] =
+	{
+		"0 0 0",
+		"0 0 300",
+		"-1024.5 2048 64",
+		"123.456789 -987.654321 0.000001",
+		"  3.5   4.5 5.5",
+		"1 2",
+		"",
+	};
+
+	for(size_t i = 0; i < sizeof(values) / sizeof(*values); i++)
+	{
+		const char *value = values[i];
+		char name[96];
+		snprintf(name, sizeof(name), "UTIL_StringToVector/\\\"%s\\\"", value);
+		Run(name, strlen(value), [&]() {
+			float vec[3];
+			UTIL_StringToVector(vec, value);
+			return (uintptr_t)vec[0] + (uintptr_t)vec[2];
+		});
+	}
+}
+
+// Send table tree with the same shape as SendTable/SendProp
+struct FakeSendTable;
+struct FakeSendProp
+{
+	FakeSendTable *m_pDataTable;
+	FakeSendTable *GetDataTable() const { return m_pDataTable; }
+};
+
+struct FakeSendTable
+{
+	std::string m_Name;
+	std::vector<FakeSendProp> m_Props;
+
+	const char *GetName() const { return m_Name.c_str(); }
+	int GetNumProps() const { return (int)m_Props.size(); }
+	FakeSendProp *GetProp(int i) { return &m_Props[i]; }
+};
+
+static std::vector<FakeSendTable *> g_Tables;
+
+// Each table gets `props` props of which `tables` are nested data tables
+static FakeSendTable *GenerateTable(const std::string &name, int depth, int props, int tables)
+{
+	FakeSendTable *pTable = new FakeSendTable;
+	g_Tables.push_back(pTable);
+	pTable->m_Name = name;
+
+	for(int i = 0; i < props; i++)
+	{
+		FakeSendProp prop = { NULL };
+		if(depth > 0 && i < tables)
+			prop.m_pDataTable = GenerateTable(name + "_" + std::to_string(i), depth - 1, props, tables);
+		pTable->m_Props.push_back(prop);
+	}
+
+	return pTable;
+}
+
+static void BenchContainsDataTable()
+{
+	// Roughly DT_CSPlayer / DT_WeaponKnife sized trees
+	struct Shape { int depth, props, tables; } shapes[] = { { 3, 24, 3 }, { 5, 32, 4 } };
+
+	for(size_t s = 0; s < sizeof(shapes) / sizeof(*shapes); s++)
+	{
+		FakeSendTable *pRoot = GenerateTable("DT_Root", shapes[s].depth, shapes[s].props, shapes[s].tables);
+
+		std::string leaf = "DT_Root";
+		for(int i = 0; i < shapes[s].depth; i++)
+			leaf += "_" + std::to_string(shapes[s].tables - 1);
+
+		char name[96];
+		snprintf(name, sizeof(name), "UTIL_ContainsDataTable/depth=%d/props=%d/found", shapes[s].depth, shapes[s].props);
+		Run(name, 0, [&]() {
+			return (uintptr_t)UTIL_ContainsDataTable(pRoot, leaf.c_str());
+		});
+
+		snprintf(name, sizeof(name), "UTIL_ContainsDataTable/depth=%d/props=%d/missing", shapes[s].depth, shapes[s].props);
+		Run(name, 0, [&]() {
+			return (uintptr_t)UTIL_ContainsDataTable(pRoot, "DT_BaseCombatWeapon");
+		});
+
+		CDataTableMembership<FakeSendTable> membership("DT_BaseCombatWeapon");
+		snprintf(name, sizeof(name), "CDataTableMembership/depth=%d/props=%d", shapes[s].depth, shapes[s].props);
+		Run(name, 0, [&]() {
+			return (uintptr_t)membership.Contains((int)s, pRoot);
+		});
+	}
+
+	for(size_t i = 0; i < g_Tables.size(); i++)
+		delete g_Tables[i];
+	g_Tables.clear();
+}
+
+static void BenchNonEdictClass()
+{
+	// Classname mix of a typical ZE map spawn
+	static const char *classnames[] =
+	{
+		"prop_dynamic", "func_button", "func_brush", "logic_relay", "trigger_multiple",
+		"info_target", "env_sprite", "func_door", "math_counter", "logic_timer",
+		"game_text", "point_teleport", "logic_auto", "player_speedmod", "point_servercommand",
+		"filter_activator_name", "ambient_generic", "func_physbox_multiplayer", "env_shake", "PROP_DYNAMIC_OVERRIDE",
+	};
+	const size_t count = sizeof(classnames) / sizeof(*classnames);
+
+	size_t bytes = 0;
+	for(size_t i = 0; i < count; i++)
+		bytes += strlen(classnames[i]);
+
+	Run("UTIL_IsNonEdictClass/map_mix", bytes, [&]() {
+		uintptr_t matches = 0;
+		for(size_t i = 0; i < count; i++)
+			matches += UTIL_IsNonEdictClass(classnames[i]);
+		return matches;
+	});
+
+	Run("UTIL_IsNonEdictClass/miss", 0, [&]() {
+		return (uintptr_t)UTIL_IsNonEdictClass("func_physbox_multiplayer");
+	});
+}
+
+static void Check(bool bCondition, const char *pszWhat)
+{
+	if(bCondition)
+		return;
+
+	fprintf(stderr, "check failed: %s\n", pszWhat);
+	exit(1);
+}
+
+struct SpawnKeyValue
+{
+	std::string key;
+	std::string value;
+};
+
+struct SpawnEntity
+{
+	std::string classname;
+	std::vector<SpawnKeyValue> keyvalues;
+};
+
+// Map load of 2000 entities with the keys a ZE map typically sets
+static std::vector<SpawnEntity> GenerateSpawnStream(int count, int *pTSpawns, int *pNonEdicts)
+{
+	static const char *classnames[] =
+	{
+		"prop_dynamic", "func_button", "func_brush", "logic_relay", "trigger_multiple",
+		"info_target", "env_sprite", "func_door", "math_counter", "logic_timer",
+		"game_text", "point_teleport", "logic_auto", "player_speedmod", "point_servercommand",
+		"filter_activator_name", "ambient_generic", "func_physbox_multiplayer", "info_player_terrorist", "info_player_counterterrorist",
+		"func_buyzone",
+	};
+	const int nClassnames = sizeof(classnames) / sizeof(*classnames);
+
+	std::vector<SpawnEntity> entities(count);
+	*pTSpawns = 0;
+	*pNonEdicts = 0;
+
+	for(int i = 0; i < count; i++)
+	{
+		SpawnEntity &entity = entities[i];
+		entity.classname = classnames[g_Random() % nClassnames];
+
+		if(entity.classname == "info_player_terrorist")
+			(*pTSpawns)++;
+		if(entity.classname.compare(0, 12, "info_player_") == 0 || UTIL_IsNonEdictClass(entity.classname.c_str()))
+			(*pNonEdicts)++;
+
+		entity.keyvalues.push_back({ "classname", entity.classname });
+		entity.keyvalues.push_back({ "targetname", "ent_" + std::to_string(i) });
+		entity.keyvalues.push_back({ "origin", std::to_string(g_Random() % 8192) + " -512 64" });
+		entity.keyvalues.push_back({ g_Random() % 2 ? "angle" : "angles", "0 90 0" });
+		entity.keyvalues.push_back({ "spawnflags", "1" });
+		entity.keyvalues.push_back({ "OnTrigger", "relay,Trigger,,0,-1" });
+		if(entity.classname == "func_buyzone")
+			entity.keyvalues.push_back({ "TeamNum", "2" });
+		if(g_Random() % 8 == 0)
+			entity.keyvalues.push_back({ "absvelocity", "0 0 300" });
+	}
+
+	return entities;
+}
+
+static void BenchSpawnStream()
+{
+	int nTSpawns, nNonEdicts;
+	std::vector<SpawnEntity> entities = GenerateSpawnStream(2000, &nTSpawns, &nNonEdicts);
+
+	size_t nKeyValues = 0;
+	for(size_t i = 0; i < entities.size(); i++)
+		nKeyValues += entities[i].keyvalues.size();
+
+	// Correctness: every T spawn is switched in both PostConstructor and the classname keyvalue
+	int nServerOnly = 0, nForcedCT = 0, nForcedCTKeys = 0, nAngles = 0;
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		const char *szClassname = entities[i].classname.c_str();
+		bool bForcedCT;
+		nServerOnly += UTIL_FixPostConstructor(&szClassname, true, &bForcedCT);
+		nForcedCT += bForcedCT;
+		Check(!bForcedCT || strcmp(szClassname, "info_player_counterterrorist") == 0, "PostConstructor CT spawn classname");
+
+		for(size_t j = 0; j < entities[i].keyvalues.size(); j++)
+		{
+			const char *szKeyName = entities[i].keyvalues[j].key.c_str();
+			const char *szValue = entities[i].keyvalues[j].value.c_str();
+			KeyValueFix fix = UTIL_FixKeyValue(&szKeyName, &szValue, true);
+			nForcedCTKeys += fix == KeyValueFix_CTSpawn;
+			nAngles += fix == KeyValueFix_Angle;
+			Check(fix != KeyValueFix_Angle || strcmp(szKeyName, "angles") == 0, "KeyValue angle rename");
+		}
+	}
+	Check(nServerOnly == nNonEdicts, "PostConstructor server only count");
+	Check(nForcedCT == nTSpawns && nForcedCTKeys == nTSpawns, "forced CT spawn count");
+	Check(nAngles > 0, "angle keys present");
+
+	Run("Workload/PostConstructor/entities=2000", 0, [&]() {
+		uintptr_t nServerOnly = 0;
+		for(size_t i = 0; i < entities.size(); i++)
+		{
+			const char *szClassname = entities[i].classname.c_str();
+			bool bForcedCT;
+			nServerOnly += UTIL_FixPostConstructor(&szClassname, true, &bForcedCT);
+		}
+		return nServerOnly;
+	});
+
+	char name[96];
+	snprintf(name, sizeof(name), "Workload/KeyValue/entities=2000/keys=%zu", nKeyValues);
+	Run(name, 0, [&]() {
+		uintptr_t nFixes = 0;
+		for(size_t i = 0; i < entities.size(); i++)
+		{
+			for(size_t j = 0; j < entities[i].keyvalues.size(); j++)
+			{
+				const char *szKeyName = entities[i].keyvalues[j].key.c_str();
+				const char *szValue = entities[i].keyvalues[j].value.c_str();
+				nFixes += UTIL_FixKeyValue(&szKeyName, &szValue, true);
+			}
+		}
+		return nFixes;
+	});
+}
+
+static void BenchKeyValueRules()
+{
+	int nTSpawns, nNonEdicts;
+	std::vector<SpawnEntity> entities = GenerateSpawnStream(2000, &nTSpawns, &nNonEdicts);
+
+	// A rule file collected over a map rotation, most of it for other maps
+	CKeyValueRules rules;
+	for(int i = 0; i < 200; i++)
+	{
+		KeyValueRule rule;
+		rule.sMap = "ze_map_" + std::to_string(i % 40) + "*";
+		rule.sClassname = i % 3 ? "func_door" : "func_*";
+		rule.sKey = i % 7 ? "speed" : "target*";
+		rule.sValue = "*";
+		rule.action = KeyValueRule_Set;
+		rule.sTo = "100";
+		rules.Add(rule);
+	}
+
+	KeyValueRule drop;
+	drop.sMap = "ze_map_0_*";
+	drop.sClassname = "func_physbox_multiplayer";
+	drop.sKey = "spawnflags";
+	drop.sValue = "*";
+	drop.action = KeyValueRule_Drop;
+	rules.Add(drop);
+
+	KeyValueRule rename;
+	rename.sMap = "*";
+	rename.sClassname = "*";
+	rename.sKey = "TeamNum";
+	rename.sValue = "2";
+	rename.action = KeyValueRule_Rename;
+	rename.sTo = "teamnum";
+	rules.Add(rename);
+
+	size_t nRules = rules.Compile("ze_map_0_v1");
+	Check(nRules == 7, "rules compiled for the map");
+
+	int nDropped = 0, nRenamed = 0, nPhysboxes = 0, nBuyzones = 0;
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		nPhysboxes += entities[i].classname == "func_physbox_multiplayer";
+		nBuyzones += entities[i].classname == "func_buyzone";
+		for(size_t j = 0; j < entities[i].keyvalues.size(); j++)
+		{
+			const char *szKeyName = entities[i].keyvalues[j].key.c_str();
+			const char *szValue = entities[i].keyvalues[j].value.c_str();
+			KeyValueRuleAction action = rules.Apply(entities[i].classname.c_str(), &szKeyName, &szValue);
+			nDropped += action == KeyValueRule_Drop;
+			nRenamed += action == KeyValueRule_Rename;
+			Check(action != KeyValueRule_Rename || strcmp(szKeyName, "teamnum") == 0, "rename rule");
+		}
+	}
+	Check(nDropped == nPhysboxes && nRenamed == nBuyzones, "rule matches");
+
+	char name[96];
+	snprintf(name, sizeof(name), "Workload/KeyValueRules/entities=2000/rules=%zu", nRules);
+	Run(name, 0, [&]() {
+		uintptr_t nApplied = 0;
+		for(size_t i = 0; i < entities.size(); i++)
+		{
+			const char *szClassname = entities[i].classname.c_str();
+			for(size_t j = 0; j < entities[i].keyvalues.size(); j++)
+			{
+				const char *szKeyName = entities[i].keyvalues[j].key.c_str();
+				const char *szValue = entities[i].keyvalues[j].value.c_str();
+				nApplied += rules.Apply(szClassname, &szKeyName, &szValue);
+			}
+		}
+		return nApplied;
+	});
+}
+
+static void BenchEdictPressure()
+{
+	// A template storm of 64 sprites per tick for 32 ticks, starting 100 edicts below the watermark
+	const int iWatermark = 1900, iBudget = 2, nPerTick = 64, nTicks = 32;
+
+	CEdictPressure pressure;
+	pressure.Configure(1, iWatermark, iBudget);
+
+	int nEdicts = iWatermark - 100;
+	for(int iTick = 0; iTick < nTicks; iTick++)
+	{
+		for(int i = 0; i < nPerTick; i++)
+		{
+			if(pressure.Check(iTick, nEdicts) == EdictPressure_Allow)
+				nEdicts++;
+		}
+	}
+	Check(nEdicts == iWatermark + (nTicks - 1) * iBudget, "edicts above the watermark only grow by the budget");
+	Check(pressure.m_nServerOnly == (uint64_t)(nTicks * nPerTick - (nEdicts - (iWatermark - 100))), "server only spawns");
+
+	pressure.Configure(2, iWatermark, 0);
+	Check(pressure.Check(nTicks, iWatermark) == EdictPressure_Refuse, "refused without budget");
+	Check(pressure.Check(nTicks, iWatermark - 1) == EdictPressure_Allow, "allowed below the watermark");
+
+	int iTick = 0;
+	Run("CEdictPressure/above_watermark", 0, [&]() {
+		return (uintptr_t)pressure.Check(iTick++ >> 6, iWatermark + 10);
+	});
+}
+
+static void BenchParkedThinkers()
+{
+	// Boss fight: 64 players on a game_ui each, a few change buttons per tick
+	const int nPlayers = 64;
+
+	CParkedThinkers parked;
+	for(int i = 1; i <= nPlayers; i++)
+		Check(parked.Park(i, 1000 + i), "game_ui parked");
+	Check(parked.Park(1, 1001) && parked.Count(1) == 1, "parking twice keeps one entry");
+
+	for(int i = 2; i <= PARKED_THINKERS_PER_CLIENT; i++)
+		Check(parked.Park(1, 2000 + i), "room for more");
+	Check(!parked.Park(1, 3000), "client full");
+
+	Check(parked.Visit(1, [](uint32_t iRef) { return iRef >= 2000; }) == PARKED_THINKERS_PER_CLIENT - 1, "woken ones dropped");
+	Check(parked.Count(1) == 1, "idle one kept");
+
+	parked.Clear(2);
+	Check(parked.Count(2) == 0 && parked.Any(), "client cleared");
+	parked.Clear();
+	Check(!parked.Any(), "all cleared");
+
+	int iTick = 0;
+	Run("CParkedThinkers/usercmds/players=64", 0, [&]() {
+		// Every player's usercmd checks its game_ui, 4 of them pressed something and get parked again
+		uintptr_t nWoken = 0;
+		for(int i = 1; i <= nPlayers; i++)
+		{
+			if(!parked.Count(i))
+				parked.Park(i, 1000 + i);
+
+			bool bChanged = ((i + iTick) & 15) == 0;
+			nWoken += parked.Visit(i, [bChanged](uint32_t) { return bChanged; });
+		}
+		iTick++;
+		return nWoken;
+	});
+}
+
+static void BenchHudMessages()
+{
+	// ZE boss fight: a boss HP game_text to all players every tick, two relays
+	// firing the same countdown on another channel, and per player texts
+	// from a filter on a third one
+	const int nPlayers = 64, nTicks = 66;
+	const double flTickInterval = 0.015;
+
+	hudtextparms_t hp;
+	memset(&hp, 0, sizeof(hp));
+	hp.x = -1.0f;
+	hp.y = 0.1f;
+	hp.holdTime = 0.5f;
+	hp.channel = 1;
+
+	hudtextparms_t countdown = hp;
+	countdown.channel = 2;
+	countdown.holdTime = 1.1f;
+	countdown.fadeoutTime = 0.5f;
+
+	hudtextparms_t personal = hp;
+	personal.channel = 3;
+	personal.fadeinTime = 0.5f;
+	personal.holdTime = 2.0f;
+	personal.fadeoutTime = 0.5f;
+
+	CHudMessageQueue queue;
+	uint64_t nSent = 0;
+	auto Send = [&](int, const hudtextparms_t &, const char *) { nSent++; };
+
+	char szText[64];
+	for(int iTick = 0; iTick < nTicks; iTick++)
+	{
+		snprintf(szText, sizeof(szText), "BOSS HP: %d", 5000 - iTick * 10);
+		queue.Queue(0, hp, szText, nPlayers);
+
+		snprintf(szText, sizeof(szText), "Door opens in %d seconds", 10 - iTick / 66);
+		queue.Queue(0, countdown, szText, nPlayers);
+		queue.Queue(0, countdown, szText, nPlayers);
+
+		for(int i = 1; i <= nPlayers; i++)
+		{
+			queue.Queue(i, personal, "You are the last human!", 1);
+			queue.Queue(i, personal, "Defend!", 1);
+		}
+
+		queue.Flush(iTick * flTickInterval, nPlayers, Send);
+	}
+
+	// HP changes every tick, the countdown goes out again once less than its hold time is left
+	// on screen (t = 0.51), personal ones stay up for more than their hold time all along
+	Check(nSent == (uint64_t)nTicks + 2 + nPlayers, "hud messages sent");
+	Check(queue.m_nReplaced == (uint64_t)nTicks * (1 + nPlayers), "hud messages replaced in the tick");
+
+	// A text resent every second with a 1.1 second hold to keep it up always goes out
+	CHudMessageQueue keepalive;
+	uint64_t nKeepAlive = 0;
+	for(int i = 0; i < 5; i++)
+	{
+		keepalive.Queue(0, countdown, "Hold the door!", nPlayers);
+		keepalive.Flush(i * 1.0, nPlayers, [&](int, const hudtextparms_t &, const char *) { nKeepAlive++; });
+	}
+	Check(nKeepAlive == 5, "hud keep alive resends");
+
+	int iTick = nTicks;
+	char name[96];
+	snprintf(name, sizeof(name), "HudMessageQueue/tick/players=%d", nPlayers);
+	Run(name, 0, [&]() {
+		snprintf(szText, sizeof(szText), "BOSS HP: %d", iTick);
+		queue.Queue(0, hp, szText, nPlayers);
+		for(int i = 1; i <= nPlayers; i++)
+			queue.Queue(i, personal, "Defend!", 1);
+
+		queue.Flush(iTick++ * flTickInterval, nPlayers, Send);
+		return (uintptr_t)nSent;
+	});
+}
+
+static void BenchCommandQueue()
+{
+	// Round start: 40 point_servercommands, every second one a duplicate
+	// from overlapping relays, plus a say to each of 64 players
+	static const char *commands[] =
+	{
+		"sv_enablebunnyhopping 1", "sv_airaccelerate 150", "mp_roundtime 10", "say ** STAGE 1 **",
+		"sm_cvar sv_gravity 800", "sv_accelerate 5", "say Defend the door!", "mp_friendlyfire 0",
+	};
+	const int nCommands = sizeof(commands) / sizeof(*commands);
+
+	CCommandQueue queue;
+	for(int i = 0; i < 40; i++)
+		Check(queue.Push(0, 100 + i, -1, -1, commands[i % nCommands], 256), "server command queued");
+	for(int i = 1; i <= 64; i++)
+		Check(queue.Push(i, 200, i, 200, "play ambient/alarms/klaxon1.wav", 256), "client command queued");
+
+	Check(queue.Depth() == (size_t)nCommands + 64, "duplicates dropped");
+	Check(queue.m_nDeduplicated == (uint64_t)(40 - nCommands), "duplicate count");
+
+	int nTicks = 0;
+	while(queue.Depth())
+	{
+		Check(queue.Drain(4, [](const QueuedCommand &) {}) == 4, "command budget");
+		nTicks++;
+	}
+	Check(nTicks == (nCommands + 64) / 4, "burst spread over ticks");
+
+	char name[96];
+	snprintf(name, sizeof(name), "CommandQueue/push_drain/commands=%d", 40 + 64);
+	Run(name, 0, [&]() {
+		for(int i = 0; i < 40; i++)
+			queue.Push(0, 100 + i, -1, -1, commands[i % nCommands], 256);
+		for(int i = 1; i <= 64; i++)
+			queue.Push(i, 200, i, 200, "play ambient/alarms/klaxon1.wav", 256);
+
+		uintptr_t nRun = 0;
+		while(queue.Depth())
+			nRun += queue.Drain(4, [](const QueuedCommand &) {});
+		return nRun;
+	});
+}
+
+static void BenchTeleportBatch()
+{
+	// Stage transition: 64 players sent to one spot, twice each from overlapping relays
+	static const float vecDest[3] = { -1024.0f, 512.25f, 64.0f };
+	static const float vecAngles[3] = { 0.0f, 90.0f, 0.0f };
+	static const float vecStart[3] = { 300.0f, 200.0f, 0.0f };
+
+	CTeleportBatch batch;
+	int iTick = 100;
+	for(int iRound = 0; iRound < 2; iRound++)
+	{
+		for(uint32_t i = 1; i <= 64; i++)
+		{
+			int iSlot;
+			bool bAdded = batch.Add(iTick, vecDest, vecAngles, i, iRound ? vecDest : vecStart, &iSlot);
+			Check(bAdded == (iRound == 0), "repeat teleports dropped");
+			if(bAdded)
+				Check(iSlot == (int)i - 1, "slots in firing order");
+		}
+	}
+	Check(batch.m_nDeduplicated == 64 && batch.m_nBatched == 63 && batch.m_nLargestBatch == 64, "batch counts");
+
+	int iSlot;
+	Check(batch.Add(iTick + 1, vecDest, vecAngles, 1, vecDest, &iSlot) && iSlot == 0, "new tick starts a new batch");
+
+	// A, then B, then A again in one tick: the last one isn't a repeat of the last teleport
+	static const float vecOther[3] = { 2048.0f, 0.0f, 64.0f };
+	static const float vecTurned[3] = { 0.0f, 180.0f, 0.0f };
+	Check(batch.Add(iTick + 2, vecDest, vecAngles, 1, vecStart, &iSlot), "teleport to A");
+	Check(batch.Add(iTick + 2, vecOther, vecAngles, 1, vecDest, &iSlot), "teleport to B");
+	Check(batch.Add(iTick + 2, vecDest, vecAngles, 1, vecOther, &iSlot) && iSlot == 0, "back to A keeps its slot");
+	Check(!batch.Add(iTick + 2, vecDest, vecAngles, 1, vecDest, &iSlot), "repeat of the last teleport dropped");
+	Check(batch.Add(iTick + 2, vecDest, vecTurned, 1, vecDest, &iSlot), "other angles go through");
+	// Moved by something the batch doesn't see (trigger_teleport)
+	Check(batch.Add(iTick + 2, vecDest, vecTurned, 1, vecOther, &iSlot), "moved in between goes through");
+
+	// Every slot of the first rings lands on its own grid point
+	std::set<std::pair<int, int>> points;
+	for(int i = 0; i < 81; i++)
+	{
+		float vecOffset[2];
+		CTeleportBatch::SpreadOffset(i, 40.0f, vecOffset);
+		Check(fabsf(vecOffset[0]) <= 160.0f && fabsf(vecOffset[1]) <= 160.0f, "81 slots fit in 4 rings");
+		points.insert(std::make_pair((int)vecOffset[0], (int)vecOffset[1]));
+	}
+	Check(points.size() == 81, "spread slots unique");
+
+	Run("TeleportBatch/stage_transition/players=64", 0, [&]() {
+		iTick++;
+		uintptr_t nSum = 0;
+		for(uint32_t i = 1; i <= 64; i++)
+		{
+			int iSlot;
+			if(batch.Add(iTick, vecDest, vecAngles, i, vecStart, &iSlot))
+			{
+				float vecOffset[2];
+				CTeleportBatch::SpreadOffset(iSlot, 40.0f, vecOffset);
+				nSum += (uintptr_t)vecOffset[0];
+			}
+		}
+		return nSum;
+	});
+}
+
+struct FakePlayer
+{
+	bool bConnected;
+	int iTeam;
+	char lifeState;
+};
+
+static void BenchBulletStorm()
+{
+	const int iMaxPlayers = 64;
+	const int nEntities = 2000;
+
+	FakePlayer players[iMaxPlayers + 1] = {};
+	for(int i = 1; i <= iMaxPlayers; i++)
+	{
+		players[i].bConnected = i <= 62;
+		players[i].iTeam = 2 + (i % 2);
+		players[i].lifeState = i % 7 == 0;
+	}
+
+	// Physboxes parented to players and a few team mapped ones
+	char physboxMap[2048];
+	memset(physboxMap, 0, sizeof(physboxMap));
+	for(int i = iMaxPlayers + 1; i < 2048; i += 5)
+		physboxMap[i] = (char)(1 + g_Random() % iMaxPlayers);
+	for(int i = iMaxPlayers + 3; i < 2048; i += 50)
+		physboxMap[i] = (char)-(1 + g_Random() % 3);
+
+	uint64_t matrix[iMaxPlayers + 1] = {};
+	for(int i = 0; i < 256; i++)
+		matrix[1 + g_Random() % iMaxPlayers] |= 1ULL << (g_Random() % iMaxPlayers);
+
+	auto GetPlayer = [&players](int client, int *pTeam, char *pLifeState) -> bool
+	{
+		if(!players[client].bConnected)
+			return false;
+
+		*pTeam = players[client].iTeam;
+		*pLifeState = players[client].lifeState;
+		return true;
+	};
+
+	// Every player fires and each bullet trace tests 16 entities along its path
+	const int nTraces = iMaxPlayers * 16;
+	std::vector<int> victims(nTraces);
+	std::vector<int> attackers(nTraces);
+	for(int i = 0; i < nTraces; i++)
+	{
+		attackers[i] = 1 + i / 16;
+		victims[i] = g_Random() % 3 ? 1 + g_Random() % nEntities : 1 + g_Random() % iMaxPlayers;
+	}
+
+	// Correctness against the rules spelled out by hand
+	for(int i = 0; i < nTraces; i++)
+	{
+		int attacker = attackers[i];
+		int index = victims[i];
+		bool bResult = UTIL_BulletPassesThrough(index, iMaxPlayers, physboxMap, attacker,
+			players[attacker].iTeam, matrix, GetPlayer);
+
+		if(index > iMaxPlayers)
+			index = physboxMap[index];
+
+		bool bExpected;
+		if(index < 0)
+			bExpected = -index == players[attacker].iTeam;
+		else if(index < 1 || index > iMaxPlayers)
+			bExpected = false;
+		else if(matrix[attacker] & (1ULL << (index - 1)))
+			bExpected = true;
+		else if(!players[index].bConnected)
+			bExpected = false;
+		else
+			bExpected = players[index].iTeam == players[attacker].iTeam || players[index].lifeState;
+
+		Check(bResult == bExpected, "ShouldHitEntity decision");
+	}
+
+	char name[96];
+	snprintf(name, sizeof(name), "Workload/ShouldHitEntity/players=%d/entities=%d/traces=%d", iMaxPlayers, nEntities, nTraces);
+	Run(name, 0, [&]() {
+		uintptr_t nPassed = 0;
+		for(int i = 0; i < nTraces; i++)
+		{
+			nPassed += UTIL_BulletPassesThrough(victims[i], iMaxPlayers, physboxMap, attackers[i],
+				players[attackers[i]].iTeam, matrix, GetPlayer);
+		}
+		return nPassed;
+	});
+}
+
+static void BenchContextFilter()
+{
+	// 64 players carrying 8 response contexts each, one filter checks all of them
+	std::vector<std::vector<SpawnKeyValue> > contexts(64);
+	int nExpected = 0;
+	for(size_t i = 0; i < contexts.size(); i++)
+	{
+		for(int j = 0; j < 8; j++)
+			contexts[i].push_back({ "ctx_" + std::to_string(j), std::to_string(g_Random() % 2) });
+
+		for(int j = 0; j < 8; j++)
+		{
+			if(contexts[i][j].key == "ctx_7" && contexts[i][j].value == "1")
+			{
+				nExpected++;
+				break;
+			}
+		}
+	}
+
+	auto Filter = [&contexts]() -> uintptr_t {
+		uintptr_t nPassed = 0;
+		for(size_t i = 0; i < contexts.size(); i++)
+		{
+			for(size_t j = 0; j < contexts[i].size(); j++)
+			{
+				if(UTIL_ContextPasses("CTX_7", contexts[i][j].key.c_str(), contexts[i][j].value.c_str()))
+				{
+					nPassed++;
+					break;
+				}
+			}
+		}
+		return nPassed;
+	};
+
+	Check(Filter() == (uintptr_t)nExpected, "filter_activator_context decision");
+	Run("Workload/PassesFilterImpl/players=64/contexts=8", 0, Filter);
+}
+
+static const IOTraceEntry *FindIOTrace(const char *pszTarget, const char *pszInput)
+{
+	const IOTraceEntry *pTop[100];
+	int nCount = IOTrace_Top(pTop, 100);
+	for(int i = 0; i < nCount; i++)
+	{
+		if(!strcmp(pTop[i]->szTarget, pszTarget) && !strcmp(pTop[i]->szInput, pszInput))
+			return pTop[i];
+	}
+
+	return NULL;
+}
+
+static void BenchIOTrace()
+{
+	// A stage relay triggered by a player opens a door right away and starts
+	// a timer half a second later through the event queue, the timer moves a train
+	static const char *pszTrigger = "Trigger", *pszOpen = "Open", *pszEnable = "Enable", *pszStart = "StartForward";
+	static int player, relay, timer;
+
+	IOTrace_Reset();
+	float flNow = 10.0f;
+
+	IOTraceEvent trigger = { pszTrigger, &player, &player, 1 };
+	IOTraceEvent open = { pszOpen, &player, &relay, 2 };
+	IOTraceEvent enable = { pszEnable, &player, &relay, 3 };
+	IOTraceEvent start = { pszStart, &player, &timer, 4 };
+
+	IOTrace_Enter("stage_relay", "player", trigger, flNow);
+	IOTrace_Enter("stage_door", "player", open, flNow);
+	IOTrace_Leave();
+	IOTrace_Output(enable, flNow, flNow + 0.5f);
+	IOTrace_Leave();
+
+	flNow += 0.5f;
+	IOTrace_Enter("stage_timer", "player", enable, flNow);
+	IOTrace_Output(start, flNow, flNow);
+	IOTrace_Leave();
+
+	IOTrace_Enter("stage_train", "player", start, flNow);
+	IOTrace_Leave();
+
+	const IOTraceEntry *pTimer = FindIOTrace("stage_timer", "Enable");
+	const IOTraceEntry *pTrain = FindIOTrace("stage_train", "StartForward");
+	const IOTraceEntry *pRelay = FindIOTrace("stage_relay", "Trigger");
+	Check(pTimer && pTimer->nMaxDepth == 2 && !strcmp(pTimer->szOrigin, "stage_relay.Trigger"), "queued event continues its chain");
+	Check(pTrain && pTrain->nMaxDepth == 3 && !strcmp(pTrain->szOrigin, "stage_relay.Trigger") &&
+		!strcmp(pTrain->szActivator, "player"), "chain carried across two queued events");
+	Check(pRelay && pRelay->nFanOut == 1 && pTimer->nFanOut == 1, "queued outputs count as fan-out");
+
+	// An event fired long after its time was serviced or cancelled, the same key starts a new chain
+	IOTrace_Enter("stage_timer", "player", enable, flNow + 5.0f);
+	IOTrace_Leave();
+	Check(FindIOTrace("stage_timer", "Enable")->nMaxDepth == 2 && g_nIOTraceUncarried == 0, "expired event");
+
+	int iRound = 0;
+	Run("IOTrace/relay_cascade", 0, [&]() {
+		flNow += 1.0f;
+		IOTraceEvent delayed = { pszEnable, &player, &relay, 100 + (iRound++ & 1023) };
+		IOTrace_Enter("stage_relay", "player", trigger, flNow);
+		IOTrace_Enter("stage_door", "player", open, flNow);
+		IOTrace_Leave();
+		IOTrace_Output(delayed, flNow, flNow + 0.5f);
+		IOTrace_Leave();
+
+		IOTrace_Enter("stage_timer", "player", delayed, flNow + 0.5f);
+		IOTrace_Leave();
+		return (uintptr_t)g_nIOTraceInputs;
+	});
+}
+
+static void BenchEventCoalesce()
+{
+	// Round start: a relay sets Color/Alpha on 64 players through !activator,
+	// and three overlapping outputs open the same 40 doors
+	struct Event
+	{
+		std::string target;
+		std::string input;
+		uintptr_t activator;
+	};
+
+	std::vector<Event> events;
+	for(int repeat = 0; repeat < 3; repeat++)
+	{
+		for(int i = 1; i <= 64; i++)
+		{
+			events.push_back({ "!activator", "Color", (uintptr_t)i });
+			events.push_back({ "!activator", "Alpha", (uintptr_t)i });
+		}
+		for(int i = 0; i < 40; i++)
+			events.push_back({ "door_" + std::to_string(i), "Open", 1 });
+		events.push_back({ "relay_round", "Trigger", 1 });
+	}
+	uint64_t nExpected = events.size() - (64 * 2 + 40 + 3);
+
+	Coalesce_SetInputs("Color, Alpha,Open");
+
+	int iTick = 0;
+	auto Tick = [&events, &iTick]() -> uintptr_t {
+		iTick++;
+		uintptr_t nQueued = 0;
+		for(size_t i = 0; i < events.size(); i++)
+		{
+			if(!Coalesce_IsTracked(events[i].input.c_str()))
+			{
+				Coalesce_Break(iTick, events[i].target.c_str());
+				nQueued++;
+				continue;
+			}
+
+			CoalesceKey key;
+			key.pszTarget = events[i].target.c_str();
+			key.pszInput = events[i].input.c_str();
+			key.pCaller = (const void *)0x1000;
+			key.pActivator = events[i].target[0] == '!' ? (const void *)events[i].activator : NULL;
+			key.flFireTime = iTick * 0.015f;
+			key.iValueType = 0;
+			memset(key.value, 0, sizeof(key.value));
+
+			nQueued += !Coalesce_Check(iTick, key);
+		}
+		return nQueued;
+	};
+
+	Coalesce_Reset();
+	Check(Tick() == events.size() - nExpected && g_nCoalesceDropped == nExpected, "coalesced event count");
+	Run("Workload/EventCoalesce/events=" + std::to_string(events.size()), 0, Tick);
+
+	// Interleaved opposite inputs and values keep their order, the last one wins
+	Coalesce_SetInputs("Enable,Disable,Alpha");
+	auto Queue = [](const char *pszInput, unsigned char value) -> bool {
+		CoalesceKey key;
+		key.pszTarget = "func_brush_wall";
+		key.pszInput = pszInput;
+		key.pCaller = (const void *)0x1000;
+		key.pActivator = NULL;
+		key.flFireTime = 1.0f;
+		key.iValueType = 0;
+		memset(key.value, 0, sizeof(key.value));
+		key.value[0] = value;
+		return Coalesce_Check(1000, key);
+	};
+
+	Check(!Queue("Enable", 0) && !Queue("Disable", 0) && !Queue("Enable", 0), "Enable, Disable, Enable all queued");
+	Check(!Queue("Toggle", 0) && !Queue("Enable", 0), "Toggle breaks up Enable, Enable");
+	Check(Queue("Enable", 0), "Enable right after Enable dropped");
+	Check(!Queue("Alpha", 0) && !Queue("Alpha", 255) && !Queue("Alpha", 0), "Alpha 0, 255, 0 all queued");
+	Check(Queue("Alpha", 0) && Queue("Enable", 0), "families are separate");
+
+	// Untracked inputs to the same target can change what the tracked ones set
+	Coalesce_SetInputs("SetSpeed");
+	Check(!Queue("SetSpeed", 100) && Queue("SetSpeed", 100), "SetSpeed 100 twice dropped");
+	Coalesce_Break(1000, "func_brush_wall");
+	Check(!Queue("SetSpeed", 100), "SetSpeedReal breaks up SetSpeed 100, SetSpeed 100");
+	Coalesce_Break(1000, "other_target");
+	Check(Queue("SetSpeed", 100), "untracked input to another target doesn't");
+	Coalesce_Reset();
+}
+
+struct SyntheticPacket
+{
+	uint32_t nAddress;
+	bool bMalformed;
+};
+
+// 10 seconds of traffic: 200 clients with 1% bad packets, 20 sources sending only junk
+static std::vector<SyntheticPacket> GeneratePacketFlood(int iMilliseconds, int nPerMillisecond, int *pAttackers)
+{
+	std::vector<SyntheticPacket> packets;
+	packets.reserve(iMilliseconds * nPerMillisecond);
+
+	*pAttackers = 20;
+	for(int i = 0; i < iMilliseconds * nPerMillisecond; i++)
+	{
+		bool bAttacker = g_Random() % 2;
+		if(bAttacker)
+			packets.push_back({ 0x0A000000u + 1 + (uint32_t)(g_Random() % *pAttackers), true });
+		else
+			packets.push_back({ 0xC0A80000u + 1 + (uint32_t)(g_Random() % 200), g_Random() % 100 == 0 });
+	}
+	return packets;
+}
+
+static void BenchRateLimit()
+{
+	const int iMilliseconds = 10000;
+	const int nPerMillisecond = 20;
+	const float flBurst = 20.0f;
+	const float flRefill = 2.0f;
+
+	int nAttackers;
+	std::vector<SyntheticPacket> packets = GeneratePacketFlood(iMilliseconds, nPerMillisecond, &nAttackers);
+
+	static CRateLimiter limiter;
+	uint32_t nNowMs = 1;
+	uint64_t nLegitBlocked = 0;
+	uint64_t nJunkProcessed = 0;
+
+	auto Process = [&]() -> uintptr_t {
+		uintptr_t nDropped = 0;
+		for(size_t i = 0; i < packets.size(); i++)
+		{
+			if(i % nPerMillisecond == 0)
+				nNowMs++;
+
+			const SyntheticPacket &packet = packets[i];
+			if(limiter.IsBlocked(packet.nAddress, nNowMs))
+			{
+				nDropped++;
+				nLegitBlocked += packet.nAddress >= 0xC0A80000u;
+				continue;
+			}
+
+			if(packet.bMalformed)
+			{
+				nJunkProcessed += packet.nAddress < 0xC0A80000u;
+				limiter.Penalize(packet.nAddress, nNowMs);
+			}
+		}
+		return nDropped;
+	};
+
+	limiter.Configure(flBurst, flRefill);
+	limiter.Reset();
+	Process();
+
+	// Every attacker gets its burst and then what refills
+	uint64_t nJunkAllowed = (uint64_t)(nAttackers * (flBurst + flRefill * iMilliseconds / 1000.0f + 1));
+	Check(nLegitBlocked == 0, "rate limiter blocked a client");
+	Check(nJunkProcessed <= nJunkAllowed, "rate limiter let junk through");
+
+	Run("Workload/RateLimit/packets=" + std::to_string(packets.size()), 0, Process);
+}
+
+struct ReplayRecord
+{
+	SpawnRecordType type;
+	bool bRuntime;
+	std::string classname;
+	std::string key;
+	std::string value;
+};
+
+// Same work the detours do per record, minus the engine calls
+static uintptr_t ReplayRecords(const std::vector<ReplayRecord> &records)
+{
+	uintptr_t nFixes = 0;
+	for(size_t i = 0; i < records.size(); i++)
+	{
+		const ReplayRecord &record = records[i];
+		if(record.type == SpawnRecord_Create)
+		{
+			const char *szClassname = record.classname.c_str();
+			bool bForcedCT;
+			nFixes += UTIL_FixPostConstructor(&szClassname, true, &bForcedCT);
+		}
+		else
+		{
+			const char *szKeyName = record.key.c_str();
+			const char *szValue = record.value.c_str();
+			KeyValueFix fix = UTIL_FixKeyValue(&szKeyName, &szValue, true);
+			if(fix == KeyValueFix_AbsVelocity)
+			{
+				float vec[3];
+				UTIL_StringToVector(vec, szValue);
+				nFixes += vec[2] != 0.0f;
+			}
+			nFixes += fix;
+		}
+	}
+	return nFixes;
+}
+
+static int Replay(int argc, char *argv[])
+{
+	std::vector<ReplayRecord> rotation;
+
+	for(int i = 0; i < argc; i++)
+	{
+		CSpawnCaptureReader reader;
+		if(!reader.Open(argv[i]))
+		{
+			fprintf(stderr, "Could not open spawn capture %s\n", argv[i]);
+			return 1;
+		}
+
+		std::vector<ReplayRecord> records;
+		size_t nCreates = 0, nKeyValues = 0, nRuntime = 0;
+		int iFirstTick = -1;
+
+		SpawnRecord record;
+		while(reader.Next(record))
+		{
+			if(iFirstTick < 0)
+				iFirstTick = record.iTick;
+
+			ReplayRecord replay;
+			replay.type = record.type;
+			// Everything after the map load tick is runtime traffic like AddOutput
+			replay.bRuntime = record.iTick != iFirstTick;
+			if(record.type == SpawnRecord_Create)
+			{
+				replay.classname = record.pszClassname;
+				nCreates++;
+			}
+			else
+			{
+				replay.key = record.pszKey;
+				replay.value = record.pszValue;
+				nKeyValues++;
+			}
+			nRuntime += replay.bRuntime;
+			records.push_back(replay);
+		}
+
+		printf("{\"map\": \"%s\", \"creates\": %zu, \"keyvalues\": %zu, \"runtime_records\": %zu}\n",
+			reader.GetMap(), nCreates, nKeyValues, nRuntime);
+
+		Run(std::string("Replay/") + reader.GetMap(), 0, [&]() {
+			return ReplayRecords(records);
+		});
+
+		rotation.insert(rotation.end(), records.begin(), records.end());
+	}
+
+	if(argc > 1)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "Replay/rotation/maps=%d", argc);
+		Run(name, 0, [&]() {
+			return ReplayRecords(rotation);
+		});
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc > 1 && strcmp(argv[1], "--replay") == 0)
+		return Replay(argc - 2, argv + 2);
+
+	if(argc > 1)
+		g_pszFilter = argv[1];
+	if(argc > 2)
+		g_flMinSeconds = atof(argv[2]);
+
+	BenchFindPattern();
+	BenchFindFunctionCall();
+	BenchStringToVector();
+	BenchContainsDataTable();
+	BenchNonEdictClass();
+
+	BenchSpawnStream();
+	BenchKeyValueRules();
+	BenchEdictPressure();
+	BenchHudMessages();
+	BenchCommandQueue();
+	BenchTeleportBatch();
+	BenchParkedThinkers();
+	BenchBulletStorm();
+	BenchContextFilter();
+	BenchIOTrace();
+	BenchEventCoalesce();
+	BenchRateLimit();
+
+	return 0;
+}
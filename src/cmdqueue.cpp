@@ -0,0 +1,82 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "cmdqueue.h"
+
+CCommandQueue::CCommandQueue() : m_nQueued(0), m_nDeduplicated(0), m_nExecuted(0), m_nMaxDepth(0)
+{
+}
+
+std::string CCommandQueue::Key(int iClient, const char *pszCommand)
+{
+	std::string key((const char *)&iClient, sizeof(iClient));
+	key += pszCommand;
+	return key;
+}
+
+bool CCommandQueue::Push(int iClient, int iEntityRef, int iActivatorRef, int iCallerRef, const char *pszCommand, size_t nMaxDepth)
+{
+	std::string key = Key(iClient, pszCommand);
+	if(m_Pending.count(key))
+	{
+		m_nDeduplicated++;
+		return true;
+	}
+
+	if(m_Queue.size() >= nMaxDepth)
+		return false;
+
+	m_Pending.insert(key);
+
+	QueuedCommand cmd;
+	cmd.iClient = iClient;
+	cmd.iEntityRef = iEntityRef;
+	cmd.iActivatorRef = iActivatorRef;
+	cmd.iCallerRef = iCallerRef;
+	cmd.sCommand = pszCommand;
+	m_Queue.push_back(cmd);
+
+	m_nQueued++;
+	if(m_Queue.size() > m_nMaxDepth)
+		m_nMaxDepth = m_Queue.size();
+
+	return true;
+}
+
+void CCommandQueue::Clear()
+{
+	m_Queue.clear();
+	m_Pending.clear();
+	m_nQueued = 0;
+	m_nDeduplicated = 0;
+	m_nExecuted = 0;
+	m_nMaxDepth = 0;
+}
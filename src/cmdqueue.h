@@ -0,0 +1,115 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_CMDQUEUE_H_
+#define _INCLUDE_CSSFIXES_CMDQUEUE_H_
+
+/**
+ * @file cmdqueue.h
+ * @brief point_servercommand/point_clientcommand commands spread over ticks.
+ *
+ * Commands are queued in firing order and run from the game frame, at most
+ * a number of commands per tick. A command
+ * identical to one still pending for the same target is dropped.
+ * Client 0 is the server.
+ *
+ * Entities are kept as serial references, running a command means calling
+ * the game's own input again, so whatever it checks still applies.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <unordered_set>
+
+struct QueuedCommand
+{
+	int iClient;		// 0 = server command
+	int iEntityRef;		// the point_servercommand/point_clientcommand
+	int iActivatorRef;
+	int iCallerRef;
+	std::string sCommand;
+};
+
+class CCommandQueue
+{
+public:
+	CCommandQueue();
+
+	// Returns false if the queue is full, the caller should run the command itself
+	bool Push(int iClient, int iEntityRef, int iActivatorRef, int iCallerRef, const char *pszCommand, size_t nMaxDepth);
+
+	/**
+	 * Execute(const QueuedCommand &cmd) runs one command.
+	 * Stops after nMaxCommands (0 = no limit). The engine only runs
+	 * server commands at the end of the frame, so timing them here
+	 * would measure nothing. Returns the number of commands run.
+	 */
+	template <typename F>
+	int Drain(int nMaxCommands, F Execute)
+	{
+		int nRun = 0;
+		while(!m_Queue.empty())
+		{
+			if(nMaxCommands > 0 && nRun >= nMaxCommands)
+				break;
+
+			QueuedCommand cmd = m_Queue.front();
+			m_Queue.pop_front();
+			m_Pending.erase(Key(cmd.iClient, cmd.sCommand.c_str()));
+
+			Execute(cmd);
+			nRun++;
+		}
+
+		m_nExecuted += nRun;
+		return nRun;
+	}
+
+	void Clear();
+	size_t Depth() const { return m_Queue.size(); }
+
+public:
+	uint64_t m_nQueued;
+	uint64_t m_nDeduplicated;
+	uint64_t m_nExecuted;
+	size_t m_nMaxDepth;		// deepest the queue got
+
+private:
+	static std::string Key(int iClient, const char *pszCommand);
+
+private:
+	std::deque<QueuedCommand> m_Queue;
+	std::unordered_set<std::string> m_Pending;
+};
+
+#endif // _INCLUDE_CSSFIXES_CMDQUEUE_H_
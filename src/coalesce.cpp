@@ -0,0 +1,274 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "coalesce.h"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+uint64_t g_nCoalesceChecked = 0;
+uint64_t g_nCoalesceDropped = 0;
+
+struct CoalesceEntry
+{
+	int iTick;				// slot is free unless this is the current tick
+	uint32_t nHash;
+
+	// Group
+	char szTarget[COALESCE_NAME_LENGTH];
+	char szFamily[COALESCE_NAME_LENGTH];	// "" for the state inputs
+	const void *pActivator;
+	float flFireTime;
+
+	// Last event queued in it, szInput "" if it can't be compared
+	uint32_t nTargetBreaks;
+	char szInput[COALESCE_NAME_LENGTH];
+	const void *pCaller;
+	int iValueType;
+	unsigned char value[COALESCE_VALUE_SIZE];
+};
+
+// Untracked inputs queued this tick per target hash, a collision only costs a drop
+struct CoalesceTargetBreaks
+{
+	int iTick;
+	uint32_t nBreaks;
+};
+
+static CoalesceEntry s_Table[COALESCE_TABLE_SIZE];
+static CoalesceTargetBreaks s_TargetBreaks[COALESCE_TABLE_SIZE];
+static int s_iTableTick = -1;
+static int s_nTableEntries = 0;
+static bool s_bTableFull = false;
+
+static char s_szInputs[COALESCE_MAX_INPUTS][COALESCE_NAME_LENGTH];
+static int s_nInputs = 0;
+
+// Inputs switching the same on/off/open/locked state of an entity, one family
+static const char *s_pszStateInputs[] =
+{
+	"Enable", "Disable", "Toggle",
+	"Open", "Close",
+	"TurnOn", "TurnOff",
+	"Lock", "Unlock",
+	"Start", "Stop",
+	"Show", "Hide",
+	"EnableMotion", "DisableMotion",
+	"StartForward", "StartBackward", "Reverse",
+};
+
+static bool IsStateInput(const char *pszInput)
+{
+	for(size_t i = 0; i < sizeof(s_pszStateInputs) / sizeof(*s_pszStateInputs); i++)
+	{
+		if(strcasecmp(s_pszStateInputs[i], pszInput) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static inline uint32_t HashBytes(uint32_t nHash, const void *pData, size_t nLength)
+{
+	const unsigned char *p = (const unsigned char *)pData;
+	for(size_t i = 0; i < nLength; i++)
+		nHash = (nHash ^ p[i]) * 16777619u;
+	return nHash;
+}
+
+static inline uint32_t HashString(uint32_t nHash, const char *pszString)
+{
+	for(; *pszString; pszString++)
+		nHash = (nHash ^ (unsigned char)tolower(*pszString)) * 16777619u;
+	return (nHash ^ 0xFF) * 16777619u;
+}
+
+void Coalesce_SetInputs(const char *pszList)
+{
+	s_nInputs = 0;
+
+	const char *p = pszList;
+	while(*p && s_nInputs < COALESCE_MAX_INPUTS)
+	{
+		while(*p == ',' || isspace((unsigned char)*p))
+			p++;
+
+		size_t nLength = 0;
+		while(p[nLength] && p[nLength] != ',' && !isspace((unsigned char)p[nLength]))
+			nLength++;
+
+		if(nLength && nLength < COALESCE_NAME_LENGTH)
+		{
+			memcpy(s_szInputs[s_nInputs], p, nLength);
+			s_szInputs[s_nInputs][nLength] = 0;
+			s_nInputs++;
+		}
+		p += nLength;
+	}
+}
+
+bool Coalesce_IsAllowed(const char *pszInput)
+{
+	for(int i = 0; i < s_nInputs; i++)
+	{
+		if(strcasecmp(s_szInputs[i], pszInput) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool Coalesce_IsTracked(const char *pszInput)
+{
+	return Coalesce_IsAllowed(pszInput) || IsStateInput(pszInput);
+}
+
+void Coalesce_Reset()
+{
+	s_iTableTick = -1;
+	s_nTableEntries = 0;
+	s_bTableFull = false;
+	g_nCoalesceChecked = 0;
+	g_nCoalesceDropped = 0;
+}
+
+static uint32_t *TargetBreaks(int iTick, uint32_t nTargetHash)
+{
+	CoalesceTargetBreaks *pBreaks = &s_TargetBreaks[nTargetHash & (COALESCE_TABLE_SIZE - 1)];
+	if(pBreaks->iTick != iTick)
+	{
+		pBreaks->iTick = iTick;
+		pBreaks->nBreaks = 0;
+	}
+
+	return &pBreaks->nBreaks;
+}
+
+void Coalesce_Break(int iTick, const char *pszTarget)
+{
+	(*TargetBreaks(iTick, HashString(2166136261u, pszTarget)))++;
+}
+
+static void StoreLast(CoalesceEntry *pEntry, const CoalesceKey &key, bool bInputFits, uint32_t nTargetBreaks)
+{
+	pEntry->nTargetBreaks = nTargetBreaks;
+	if(bInputFits)
+		strcpy(pEntry->szInput, key.pszInput);
+	else
+		pEntry->szInput[0] = 0;
+
+	pEntry->pCaller = key.pCaller;
+	pEntry->iValueType = key.iValueType;
+	memcpy(pEntry->value, key.value, sizeof(pEntry->value));
+}
+
+bool Coalesce_Check(int iTick, const CoalesceKey &key)
+{
+	if(iTick != s_iTableTick)
+	{
+		s_iTableTick = iTick;
+		s_nTableEntries = 0;
+		s_bTableFull = false;
+	}
+
+	// Events we can't remember may sit between two identical ones, stop dropping for this tick
+	if(s_bTableFull)
+		return false;
+
+	// Nothing else can target a name longer than a slot
+	if(strlen(key.pszTarget) >= COALESCE_NAME_LENGTH)
+		return false;
+
+	bool bState = IsStateInput(key.pszInput);
+	bool bInputFits = strlen(key.pszInput) < COALESCE_NAME_LENGTH;
+	if(!bState && !bInputFits)
+		return false;
+
+	bool bAllowed = bInputFits && Coalesce_IsAllowed(key.pszInput);
+	if(bAllowed)
+		g_nCoalesceChecked++;
+
+	const char *pszFamily = bState ? "" : key.pszInput;
+
+	uint32_t nHash = HashString(2166136261u, key.pszTarget);
+	uint32_t nTargetBreaks = *TargetBreaks(iTick, nHash);
+	nHash = HashString(nHash, pszFamily);
+	nHash = HashBytes(nHash, &key.pActivator, sizeof(key.pActivator));
+	nHash = HashBytes(nHash, &key.flFireTime, sizeof(key.flFireTime));
+
+	for(int i = 0; i < COALESCE_TABLE_SIZE; i++)
+	{
+		CoalesceEntry *pEntry = &s_Table[(nHash + i) & (COALESCE_TABLE_SIZE - 1)];
+		if(pEntry->iTick != iTick)
+		{
+			if(s_nTableEntries >= COALESCE_TABLE_SIZE / 4 * 3)
+			{
+				s_bTableFull = true;
+				return false;
+			}
+
+			s_nTableEntries++;
+			pEntry->iTick = iTick;
+			pEntry->nHash = nHash;
+			strcpy(pEntry->szTarget, key.pszTarget);
+			strcpy(pEntry->szFamily, pszFamily);
+			pEntry->pActivator = key.pActivator;
+			pEntry->flFireTime = key.flFireTime;
+			StoreLast(pEntry, key, bInputFits, nTargetBreaks);
+			return false;
+		}
+
+		if(pEntry->nHash != nHash ||
+			pEntry->pActivator != key.pActivator ||
+			pEntry->flFireTime != key.flFireTime ||
+			strcasecmp(pEntry->szTarget, key.pszTarget) != 0 ||
+			strcasecmp(pEntry->szFamily, pszFamily) != 0)
+		{
+			continue;
+		}
+
+		if(bAllowed &&
+			pEntry->nTargetBreaks == nTargetBreaks &&
+			pEntry->pCaller == key.pCaller &&
+			pEntry->iValueType == key.iValueType &&
+			memcmp(pEntry->value, key.value, sizeof(pEntry->value)) == 0 &&
+			strcasecmp(pEntry->szInput, key.pszInput) == 0)
+		{
+			g_nCoalesceDropped++;
+			return true;
+		}
+
+		StoreLast(pEntry, key, bInputFits, nTargetBreaks);
+		return false;
+	}
+
+	return false;
+}
@@ -0,0 +1,87 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_COALESCE_H_
+#define _INCLUDE_CSSFIXES_COALESCE_H_
+
+/**
+ * @file coalesce.h
+ * @brief Drops entity I/O events repeating the last one queued for the same target.
+ *
+ * Events are grouped per target, fire time and input family, for
+ * "!activator"/"!caller"/... targets also per activator. A family is the
+ * input itself, except for the state inputs (Enable/Disable/Toggle,
+ * Open/Close, TurnOn/TurnOff, Lock/Unlock, ...) which share one. An event
+ * is dropped only if input, value and caller match the last event queued
+ * in its group, so anything changing the same state in between keeps it,
+ * and the outcome is that of the last event as without coalescing.
+ * Inputs that aren't tracked can still touch the same state (SetSpeedReal
+ * between two SetSpeed), any of them ends the runs of its target.
+ *
+ * Only inputs on the allow-list are ever dropped, order sensitive ones must
+ * stay off it. The table only remembers events queued during the current
+ * tick, once it's full nothing more is dropped that tick.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define COALESCE_TABLE_SIZE		1024	// power of two
+#define COALESCE_NAME_LENGTH	64
+#define COALESCE_MAX_INPUTS		64
+#define COALESCE_VALUE_SIZE		12
+
+struct CoalesceKey
+{
+	const char *pszTarget;
+	const char *pszInput;
+	const void *pCaller;
+	const void *pActivator;
+	float flFireTime;	// CEventQueue orders by it, equal times in queueing order
+	int iValueType;
+	unsigned char value[COALESCE_VALUE_SIZE];	// only the bytes used by iValueType, rest zero
+};
+
+extern uint64_t g_nCoalesceChecked;
+extern uint64_t g_nCoalesceDropped;
+
+// Comma separated, case insensitive like input dispatch
+void Coalesce_SetInputs(const char *pszList);
+bool Coalesce_IsAllowed(const char *pszInput);
+// Allowed, or shares its family with inputs that could be, these have to go through Coalesce_Check
+bool Coalesce_IsTracked(const char *pszInput);
+// Returns true if the event repeats the last one of its group and is allowed to be dropped, otherwise remembers it
+bool Coalesce_Check(int iTick, const CoalesceKey &key);
+// An untracked input queued for pszTarget, the next event of every group of that target is kept
+void Coalesce_Break(int iTick, const char *pszTarget);
+void Coalesce_Reset();
+
+#endif // _INCLUDE_CSSFIXES_COALESCE_H_
@@ -31,6 +31,23 @@
 
 #include "extension.h"
 #include "convarhelper.h"
+#include "profiler.h"
+#include "flightrecorder.h"
+#include "spawncapture.h"
+#include "statspage.h"
+#include "asynclog.h"
+#include "iotracer.h"
+#include "coalesce.h"
+#include "offsets.h"
+#include "kvrules.h"
+#include "factorycache.h"
+#include "hudmsg.h"
+#include "cmdqueue.h"
+#include "teleport.h"
+#include "netmsg.h"
+#include "ratelimit.h"
+#include "pakcache.h"
+#include "utils.h"
 #include "CDetour/detours.h"
 #include "iplayerinfo.h"
 #include <sourcehook.h>
@@ -40,6 +57,11 @@
 #include <ispatialpartition.h>
 #include <utlvector.h>
 #include <string_t.h>
+#include <igameevents.h>
+#include <cdll_int.h>
+#include <networkstringtabledefs.h>
+
+#include <tier0/threadtools.h>
 
 #define VPROF_ENABLED
 #include <tier0/vprof.h>
@@ -48,70 +70,6 @@
 #define ClearBit(A,I)	((A)[(I) >> 5] &= ~(1 << ((I) & 31)))
 #define CheckBit(A,I)	!!((A)[(I) >> 5] & (1 << ((I) & 31)))
 
-bool UTIL_ContainsDataTable(SendTable *pTable, const char *name)
-{
-	const char *pname = pTable->GetName();
-	int props = pTable->GetNumProps();
-	SendProp *prop;
-	SendTable *table;
-
-	if (pname && strcmp(name, pname) == 0)
-		return true;
-
-	for (int i=0; i<props; i++)
-	{
-		prop = pTable->GetProp(i);
-
-		if ((table = prop->GetDataTable()) != NULL)
-		{
-			pname = table->GetName();
-			if (pname && strcmp(name, pname) == 0)
-			{
-				return true;
-			}
-
-			if (UTIL_ContainsDataTable(table, name))
-			{
-				return true;
-			}
-		}
-	}
-
-	return false;
-}
-
-void UTIL_StringToVector( float *pVector, const char *pString )
-{
-	char *pstr, *pfront, tempString[128];
-	int	j;
-
-	Q_strncpy( tempString, pString, sizeof(tempString) );
-	pstr = pfront = tempString;
-
-	for ( j = 0; j < 3; j++ )			// lifted from pr_edict.c
-	{
-		pVector[j] = atof( pfront );
-
-		// skip any leading whitespace
-		while ( *pstr && *pstr <= ' ' )
-			pstr++;
-
-		// skip to next whitespace
-		while ( *pstr && *pstr > ' ' )
-			pstr++;
-
-		if (!*pstr)
-			break;
-
-		pstr++;
-		pfront = pstr;
-	}
-	for ( j++; j < 3; j++ )
-	{
-		pVector[j] = 0;
-	}
-}
-
 class CTraceFilterSimple : public CTraceFilter
 {
 public:
@@ -127,6 +85,24 @@ public:
 	virtual void SetPassEntity2( const IHandleEntity *pPassEntity2 ) = 0;
 };
 
+class IEntityFactory
+{
+public:
+	virtual IServerNetworkable *Create( const char *pClassName ) = 0;
+	virtual void Destroy( IServerNetworkable *pNetworkable ) = 0;
+	virtual size_t GetEntitySize() = 0;
+};
+
+class IEntityFactoryDictionary
+{
+public:
+	virtual void InstallFactory( IEntityFactory *pFactory, const char *pClassName ) = 0;
+	virtual IServerNetworkable *Create( const char *pClassName ) = 0;
+	virtual void Destroy( const char *pClassName, IServerNetworkable *pNetworkable ) = 0;
+	virtual IEntityFactory *FindFactory( const char *pClassName ) = 0;
+	virtual const char *GetCannonicalName( const char *pClassName ) = 0;
+};
+
 struct SrcdsPatch
 {
 	const char *pSignature; // function symbol
@@ -139,6 +115,7 @@ struct SrcdsPatch
 	int occurrences = 1; // maximum(!) number of occurences to patch
 	bool functionCall = false; // true = FindFunctionCall (pPatchSignature = function symbol) | false = FindPattern
 	const char *pFunctionLibrary = ""; // library of function symbol pPatchSignature for functionCall = true
+	void *pRedirect = NULL; // != NULL = patch the 5 byte call with a call to this instead of pPatch
 
 	struct Restore
 	{
@@ -152,11 +129,28 @@ struct SrcdsPatch
 };
 
 class CBaseEntity;
+class CUserCmd;
+class IMoveHelper;
 struct variant_hax
 {
 	const char *pszValue;
 };
 
+// Complete variant_t layout, variant_hax only covers the string value
+struct variant_full_hax
+{
+	unsigned char data[12];
+	unsigned long eVal;
+	int fieldType;
+};
+
+struct netpacket_hax
+{
+	int type; // netadrtype_t
+	unsigned char ip[4];
+	unsigned short port;
+};
+
 struct ResponseContext_t
 {
 	string_t m_iszName;
@@ -178,9 +172,6 @@ struct inputdata_t
 
 typedef bool (*ShouldHitFunc_t)( IHandleEntity *pHandleEntity, int contentsMask );
 
-uintptr_t FindPattern(uintptr_t BaseAddr, const unsigned char *pData, const char *pPattern, size_t MaxSize);
-uintptr_t FindFunctionCall(uintptr_t BaseAddr, uintptr_t Function, size_t MaxSize);
-
 
 /**
  * @file extension.cpp
@@ -195,6 +186,39 @@ ConVar *g_SvSkipCashReset = CreateConVar("sv_cssfixes_skip_cash_reset", "1", FCV
 ConVar *g_SvGameEndUnFreeze = CreateConVar("sv_cssfixes_gameend_unfreeze", "1", FCVAR_NOTIFY, "Allow people to run around freely after game end");
 ConVar *g_SvAlwaysTransmitPointViewControl = CreateConVar("sv_cssfixes_always_transmit_point_viewcontrol", "0", FCVAR_NOTIFY, "Always transmit point_viewcontrol for debugging purposes");
 ConVar *g_SvLogs = CreateConVar("sv_cssfixes_logs", "0", FCVAR_NOTIFY, "Add extra logs of action performed");
+ConVar *g_SvUseCacheTicks = CreateConVar("sv_cssfixes_use_cache_ticks", "0", FCVAR_NOTIFY, "Reuse the last +USE target for this many ticks while the player's view doesn't move (0 = disabled)");
+ConVar *g_SvUseCacheDistance = CreateConVar("sv_cssfixes_use_cache_distance", "1.0", FCVAR_NOTIFY, "Maximum eye position change in units for a cached +USE target to stay valid");
+ConVar *g_SvUseCacheAngle = CreateConVar("sv_cssfixes_use_cache_angle", "1.0", FCVAR_NOTIFY, "Maximum eye angle change in degrees for a cached +USE target to stay valid");
+ConVar *g_SvUseMaxPerSecond = CreateConVar("sv_cssfixes_use_max_per_second", "0", FCVAR_NOTIFY, "Maximum FindUseEntity evaluations per player per second (0 = unlimited)");
+ConVar *g_SvProfile = CreateConVar("sv_cssfixes_profile", "0", FCVAR_NOTIFY, "Profile every CSSFixes detour and hook, read with sm_cssfixes_stats");
+ConVar *g_SvFlightRecThreshold = CreateConVar("sv_cssfixes_flightrec_threshold_ms", "0", FCVAR_NOTIFY, "Dump the frames around any server frame longer than this many milliseconds to logs/cssfixes_spike_*.bin (0 = disabled)");
+ConVar *g_SvFlightRecFrames = CreateConVar("sv_cssfixes_flightrec_frames", "64", FCVAR_NOTIFY, "Number of frames around a spike the flight recorder writes (max 1024)");
+ConVar *g_SvSpawnCapture = CreateConVar("sv_cssfixes_spawncapture", "0", FCVAR_NOTIFY, "Capture the entity spawn and keyvalue stream of each map to data/cssfixes_spawns_<map>.cskv for offline replay");
+ConVar *g_SvStatsPage = CreateConVar("sv_cssfixes_statspage", "0", FCVAR_NOTIFY, "Publish extension counters to the memory mapped file data/cssfixes_stats.shm for external monitoring");
+ConVar *g_SvIOTrace = CreateConVar("sv_cssfixes_iotrace", "0", FCVAR_NOTIFY, "Trace entity inputs and outputs, logs the most expensive targetname/input pairs every round");
+ConVar *g_SvIOTraceTop = CreateConVar("sv_cssfixes_iotrace_top", "10", FCVAR_NOTIFY, "Number of targetname/input pairs logged by the I/O tracer");
+ConVar *g_SvCoalesceEvents = CreateConVar("sv_cssfixes_coalesce_events", "0", FCVAR_NOTIFY, "Drop entity I/O events repeating the last one queued this tick for the same target, fire time and input");
+ConVar *g_SvNetMsgInterval = CreateConVar("sv_cssfixes_netmsg_interval", "60", FCVAR_NOTIFY, "Log the packet header messages counted per source address every this many seconds (0 = disabled)");
+ConVar *g_SvNetLimit = CreateConVar("sv_cssfixes_netlimit", "0", FCVAR_NOTIFY, "Drop packets from sources that repeatedly send malformed split packets before they are processed, connected clients are never blocked");
+ConVar *g_SvNetLimitBurst = CreateConVar("sv_cssfixes_netlimit_burst", "20", FCVAR_NOTIFY, "Malformed split packets a source may send in a row before it is blocked");
+ConVar *g_SvNetLimitRefill = CreateConVar("sv_cssfixes_netlimit_refill", "2", FCVAR_NOTIFY, "Malformed split packets forgiven per second");
+ConVar *g_SvUserInfoInterval = CreateConVar("sv_cssfixes_userinfo_interval", "0", FCVAR_NOTIFY, "Network userinfo changes of a client at most once per this many seconds, the latest change is sent when it expires (0 = disabled)");
+ConVar *g_SvPakCache = CreateConVar("sv_cssfixes_pakcache", "1", FCVAR_NOTIFY, "Remember BSP pakfile lookups case insensitively for the duration of a map");
+ConVar *g_SvKeyValueRules = CreateConVar("sv_cssfixes_keyvalue_rules", "1", FCVAR_NOTIFY, "Apply the keyvalue rewrite rules from configs/cssfixes_keyvalues.cfg, read at every map start");
+ConVar *g_SvFactoryCache = CreateConVar("sv_cssfixes_factorycache", "1", FCVAR_NOTIFY, "Create entities through a cache of classname to entity factory instead of the engine's factory dictionary");
+ConVar *g_SvEdictPressure = CreateConVar("sv_cssfixes_edict_pressure", "0", FCVAR_NOTIFY, "Above sv_cssfixes_edict_watermark edicts, spawn sv_cssfixes_edict_pressure_classes without an edict (1) or refuse them (2) once the per tick budget is used up (0 = disabled)");
+ConVar *g_SvEdictWatermark = CreateConVar("sv_cssfixes_edict_watermark", "1900", FCVAR_NOTIFY, "Used edicts from which sv_cssfixes_edict_pressure kicks in");
+ConVar *g_SvEdictBudget = CreateConVar("sv_cssfixes_edict_budget", "2", FCVAR_NOTIFY, "sv_cssfixes_edict_pressure_classes spawns per tick that still get an edict above the watermark");
+ConVar *g_SvEdictPressureClasses = CreateConVar("sv_cssfixes_edict_pressure_classes", "env_sprite,env_spritetrail,env_glow,env_smokestack,env_steam,env_spark,env_splash,env_bubbles", FCVAR_NOTIFY, "Comma separated cosmetic classnames sv_cssfixes_edict_pressure may spawn without an edict or refuse, only list classes nothing depends on");
+ConVar *g_SvHudMsgCoalesce = CreateConVar("sv_cssfixes_hudmsg_coalesce", "0", FCVAR_NOTIFY, "Send only the last game_text message per player and channel of a tick, and skip messages identical to one that stays on screen for their hold time anyway");
+ConVar *g_SvCmdQueue = CreateConVar("sv_cssfixes_cmdqueue", "0", FCVAR_NOTIFY, "Queue point_servercommand/point_clientcommand inputs and fire them from the game frame within a per tick budget, identical pending commands are dropped");
+ConVar *g_SvCmdQueueCommands = CreateConVar("sv_cssfixes_cmdqueue_commands", "4", FCVAR_NOTIFY, "Queued inputs fired per tick at most (0 = no limit)");
+ConVar *g_SvCmdQueueMax = CreateConVar("sv_cssfixes_cmdqueue_max", "256", FCVAR_NOTIFY, "Queued commands at most, commands past this run right away");
+ConVar *g_SvTeleportBatch = CreateConVar("sv_cssfixes_teleport_batch", "0", FCVAR_NOTIFY, "Skip point_teleport teleports of a player to a spot the player was already sent to this tick, and track teleports to the same spot as a batch");
+ConVar *g_SvTeleportSpread = CreateConVar("sv_cssfixes_teleport_spread", "0", FCVAR_NOTIFY, "Units between players of a sv_cssfixes_teleport_batch batch, placed in a square spiral around the destination where a player fits with ground below, otherwise at the destination (0 = stack them)");
+ConVar *g_SvViewControlTransmit = CreateConVar("sv_cssfixes_viewcontrol_transmit", "0", FCVAR_NOTIFY, "Transmit an enabled point_viewcontrol only to the players viewing through it and to SetViewControlDebug clients, disabled ones to nobody (applies from the next camera Enable/Disable)");
+ConVar *g_SvGameUIEvents = CreateConVar("sv_cssfixes_gameui_events", "0", FCVAR_NOTIFY, "Stop the think of an idle game_ui and wake it up from its player's usercmds once the buttons change, instead of polling every tick");
+ConVar *g_SvCoalesceInputs = CreateConVar("sv_cssfixes_coalesce_inputs", "Alpha,Color,SetSpeed,Kill,KillHierarchy", FCVAR_NOTIFY, "Comma separated inputs sv_cssfixes_coalesce_events may merge, leave order sensitive inputs out");
 
 std::vector<SrcdsPatch> gs_Patches = {};
 
@@ -209,11 +233,97 @@ CDetour *g_pDetour_CTraceFilterSimple = NULL;
 CDetour *g_pDetour_KeyValue = NULL;
 CDetour *g_pDetour_FireBullets = NULL;
 CDetour *g_pDetour_SwingOrStab = NULL;
+CDetour *g_pDetour_AcceptInput = NULL;
+CDetour *g_pDetour_AddEvent = NULL;
+CDetour *g_pDetour_NET_GetLong = NULL;
+CDetour *g_pDetour_FillUserInfo = NULL;
+CDetour *g_pDetour_GetFileInfo = NULL;
+CDetour *g_pDetour_UTIL_HudMessage = NULL;
+CDetour *g_pDetour_ServerCommandInput = NULL;
+CDetour *g_pDetour_ClientCommandInput = NULL;
+CDetour *g_pDetour_PointTeleportInput = NULL;
+CDetour *g_pDetour_ViewControlUpdateTransmitState = NULL;
+CDetour *g_pDetour_ShouldTransmit = NULL;
+CDetour *g_pDetour_GameUIThink = NULL;
+CDetour *g_pDetour_PlayerRunCommand = NULL;
 int g_SH_SkipTwoEntitiesShouldHitEntity = 0;
 int g_SH_SimpleShouldHitEntity = 0;
 
 int g_iMaxPlayers = 0;
 
+CGlobalVars *gpGlobals = NULL;
+IGameEventManager2 *gameevents = NULL;
+INetworkStringTableContainer *netstringtables = NULL;
+IEngineTrace *enginetrace = NULL;
+
+CSpawnCaptureWriter g_SpawnCapture;
+
+StatsPage *g_pStatsPage = NULL;
+uint64_t g_nEdictsSaved = 0;
+uint32_t g_nPatchesApplied = 0;
+uint64_t g_nTraceFilterChecks = 0;
+uint64_t g_nTraceFilterPassThrough = 0;
+
+bool g_bIOTrace = false;
+bool g_bCoalesceEvents = false;
+char g_szCoalesceInputs[512] = "";
+
+bool g_bNetLimit = false;
+CRateLimiter g_NetLimiter;
+uint32_t g_ClientAddress[SM_MAXPLAYERS + 1];	// host order, 0 for fake clients and free slots
+
+struct UserInfoCache
+{
+	player_info_t info;		// last one in the userinfo table
+	player_info_t pending;	// held back by sv_cssfixes_userinfo_interval
+	bool bValid;
+	bool bPending;
+	double flLastUpdate;
+};
+UserInfoCache g_UserInfoCache[SM_MAXPLAYERS + 1];
+uint64_t g_nUserInfoSuppressed = 0;
+uint64_t g_nUserInfoBytesSaved = 0;
+
+// Pack files stay mounted between LevelInit and LevelShutdown, only cache then
+bool g_bPakCache = false;
+CPakFileInfoCache g_PakCache;
+
+// Compiled for the current map in Hook_LevelInit
+CKeyValueRules g_KeyValueRules;
+
+IEntityFactoryDictionary *g_pEntityFactoryDictionary = NULL;
+CFactoryCache g_FactoryCache;
+
+bool g_bHudMsgCoalesce = false;
+CHudMessageQueue g_HudMessages;
+
+bool g_bCmdQueue = false;
+CCommandQueue g_CmdQueue;
+
+bool g_bTeleportBatch = false;
+float g_flTeleportSpread = 0.0f;
+CTeleportBatch g_TeleportBatch;
+
+bool g_bViewControlTransmit = false;
+void *g_pViewControlVTable = NULL;	// tells cameras apart in CBaseEntity::ShouldTransmit
+bool g_bViewControlDebug[SM_MAXPLAYERS + 1];
+uint64_t g_nViewControlChecks = 0;
+uint64_t g_nViewControlSent = 0;
+
+typedef void (*SetNextThink_t)(CBaseEntity *pThis, float flNextThinkTime, const char *szContext);
+SetNextThink_t g_pSetNextThink = NULL;
+
+bool g_bGameUIEvents = false;
+CParkedThinkers g_ParkedGameUIs;	// idle game_ui per player
+uint64_t g_nGameUIParked = 0;
+uint64_t g_nGameUIWoken = 0;
+
+CEdictPressure g_EdictPressure;
+CNameList g_EdictPressureClasses;
+// Classname pointer the PostConstructor of a demoted spawn is called with, entities its
+// constructor creates get another one (and a nested CreateEntityByName clears it meanwhile)
+const char *g_pszEdictPressureServerOnly = NULL;
+
 uintptr_t g_CTraceFilterNoNPCsOrPlayer = 0;
 CTraceFilterSkipTwoEntities *g_CTraceFilterSkipTwoEntities = NULL;
 CTraceFilterSimple *g_CTraceFilterSimple = NULL;
@@ -221,63 +331,356 @@ CTraceFilterSimple *g_CTraceFilterSimple = NULL;
 /* Fix crash in CBaseFilter::InputTestActivator */
 DETOUR_DECL_MEMBER1(DETOUR_InputTestActivator, void, inputdata_t *, inputdata)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_InputTestActivator);
+
 	if(!inputdata || !inputdata->pActivator || !inputdata->pCaller)
 		return;
 
 	DETOUR_MEMBER_CALL(DETOUR_InputTestActivator)(inputdata);
 }
 
-const char *pszNonEdicts[] =
-{
-	"game_score",
-	"game_text",
-	"game_ui",
-	"logic_auto",	// bruh
-	"phys_thruster",
-	"phys_keepupright",
-	"player_speedmod",
-	"player_weaponstrip",
-	"point_clientcommand",
-	"point_servercommand",
-	"point_teleport",
+/* point_servercommand: queue the command instead of running it inside entity I/O */
+DETOUR_DECL_MEMBER1(DETOUR_ServerCommandInput, void, inputdata_t *, inputdata)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_ServerCommandInput);
+	const char *pszCommand = inputdata ? inputdata->value.pszValue : NULL;
+	if(!g_bCmdQueue || !pszCommand || !pszCommand[0] ||
+		!g_CmdQueue.Push(0, gamehelpers->EntityToReference((CBaseEntity *)this),
+			inputdata->pActivator ? gamehelpers->EntityToReference(inputdata->pActivator) : -1,
+			inputdata->pCaller ? gamehelpers->EntityToReference(inputdata->pCaller) : -1,
+			pszCommand, (size_t)g_SvCmdQueueMax->GetInt()))
+	{
+		DETOUR_MEMBER_CALL(DETOUR_ServerCommandInput)(inputdata);
+	}
+}
+
+/* point_clientcommand: same for commands sent to the activating player */
+DETOUR_DECL_MEMBER1(DETOUR_ClientCommandInput, void, inputdata_t *, inputdata)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_ClientCommandInput);
+	const char *pszCommand = inputdata ? inputdata->value.pszValue : NULL;
+	if(!g_bCmdQueue || !pszCommand || !pszCommand[0] || !inputdata->pActivator)
+		return DETOUR_MEMBER_CALL(DETOUR_ClientCommandInput)(inputdata);
+
+	// Non player activators are left to the game
+	int iClient = gamehelpers->EntityToBCompatRef(inputdata->pActivator);
+	IGamePlayer *pPlayer = (iClient >= 1 && iClient <= g_iMaxPlayers) ? playerhelpers->GetGamePlayer(iClient) : NULL;
+	if(!pPlayer || !pPlayer->IsInGame() ||
+		!g_CmdQueue.Push(iClient, gamehelpers->EntityToReference((CBaseEntity *)this),
+			gamehelpers->EntityToReference(inputdata->pActivator),
+			inputdata->pCaller ? gamehelpers->EntityToReference(inputdata->pCaller) : -1,
+			pszCommand, (size_t)g_SvCmdQueueMax->GetInt()))
+	{
+		DETOUR_MEMBER_CALL(DETOUR_ClientCommandInput)(inputdata);
+	}
+}
+
+// inputdata_t with the complete variant_t, for inputs fired by CSSFixes itself
+struct inputdata_full_hax
+{
+	CBaseEntity *pActivator;
+	CBaseEntity *pCaller;
+	variant_full_hax value;
+	int nOutputID;
 };
 
-DETOUR_DECL_MEMBER1(DETOUR_PostConstructor, void, const char *, szClassname)
+/* Runs the game's own input, which only inserts into the command buffer (or sends
+ * to the client), the engine executes server commands on its next buffer pass as usual */
+void ExecuteQueuedCommand(const QueuedCommand &cmd)
 {
-	VPROF_ENTER_SCOPE("CSSFixes::DETOUR_PostConstructor");
+	CBaseEntity *pEntity = gamehelpers->ReferenceToEntity(cmd.iEntityRef);
+	if(!pEntity)
+		return;
 
-	CBaseEntity *pEntity = (CBaseEntity *)this;
+	// Players that left take their commands with them
+	CBaseEntity *pActivator = cmd.iActivatorRef != -1 ? gamehelpers->ReferenceToEntity(cmd.iActivatorRef) : NULL;
+	if(cmd.iClient && !pActivator)
+		return;
 
-	static datamap_t *pMap = gamehelpers->GetDataMap(pEntity);
-	static typedescription_t *td = gamehelpers->FindInDataMap(pMap, "m_iEFlags");
-	static uint32 offset = td->fieldOffset[TD_OFFSET_NORMAL];
+	inputdata_full_hax inputdata;
+	memset(&inputdata, 0, sizeof(inputdata));
+	inputdata.pActivator = pActivator;
+	inputdata.pCaller = cmd.iCallerRef != -1 ? gamehelpers->ReferenceToEntity(cmd.iCallerRef) : NULL;
 
-	if(strncasecmp(szClassname, "info_player_", 12) == 0)
+	const char *pszCommand = cmd.sCommand.c_str();
+	memcpy(inputdata.value.data, &pszCommand, sizeof(pszCommand));
+	inputdata.value.eVal = INVALID_EHANDLE_INDEX;
+	inputdata.value.fieldType = FIELD_STRING;
+
+	if(!cmd.iClient)
+		DETOUR_MEMBER_MCALL_ORIGINAL(DETOUR_ServerCommandInput, pEntity)((inputdata_t *)&inputdata);
+	else
+		DETOUR_MEMBER_MCALL_ORIGINAL(DETOUR_ClientCommandInput, pEntity)((inputdata_t *)&inputdata);
+}
+
+// Everything a player collides with but the players themselves, they are the ones being spread
+class CTraceFilterSkipPlayers : public CTraceFilter
+{
+public:
+	virtual bool ShouldHitEntity(IHandleEntity *pHandleEntity, int contentsMask)
 	{
-		// Spawnpoints don't need edicts...
-		*(uint32 *)((intptr_t)pEntity + offset) |= (1<<9); // EFL_SERVER_ONLY
+		int index = pHandleEntity->GetRefEHandle().GetEntryIndex();
+		if(index < 1 || index > g_iMaxPlayers)
+			return true;
 
-		// Only CT spawnpoints
-		if(g_SvForceCTSpawn->GetInt() && strcasecmp(szClassname, "info_player_terrorist") == 0)
-		{
-			if (g_SvLogs->GetInt())
-			{
-				g_pSM->LogMessage(myself, "Forcing CT spawn");
-			}
-			szClassname = "info_player_counterterrorist";
-		}
+		// Static props have handles of their own, only the player entity itself is skipped
+		return gamehelpers->ReferenceToEntity(index) != (CBaseEntity *)pHandleEntity;
+	}
+};
+
+#define TELEPORT_STEP_HEIGHT 18.0f	// sv_stepsize
+
+/* point_teleport: stage transitions fire one per player at the same destination in the same tick.
+ * A repeat of a player's last teleport of the tick is dropped while the player is still where that one
+ * put it, the rest can be spread around the destination so the players don't all have to be pushed
+ * apart by the movement code afterwards. */
+DETOUR_DECL_MEMBER1(DETOUR_PointTeleportInput, void, inputdata_t *, inputdata)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_PointTeleportInput);
+	if(!g_bTeleportBatch || !inputdata || !inputdata->pActivator)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	// Only the "one per player" case, named targets resolve to something else on every call
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+	const char *pszTarget = STRING(*(string_t *)((uint8_t *)pEntity + g_Offsets.m_target));
+	if(!pszTarget || strcasecmp(pszTarget, "!activator"))
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	int iClient = gamehelpers->EntityToBCompatRef(inputdata->pActivator);
+	if(iClient < 1 || iClient > g_iMaxPlayers)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(iClient);
+	IPlayerInfo *pInfo = pPlayer ? pPlayer->GetPlayerInfo() : NULL;
+	if(!pInfo)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
 
-		DETOUR_MEMBER_CALL(DETOUR_PostConstructor)(szClassname);
+	Vector *pDest = (Vector *)((uint8_t *)pEntity + g_Offsets.m_vSaveOrigin);
+	QAngle *pAngles = (QAngle *)((uint8_t *)pEntity + g_Offsets.m_vSaveAngles);
+	Vector vecCurrent = pInfo->GetAbsOrigin();
+	uint32_t iTarget = gamehelpers->EntityToReference(inputdata->pActivator);
+
+	int iSlot;
+	if(!g_TeleportBatch.Add(gpGlobals->tickcount, pDest->Base(), pAngles->Base(), iTarget, vecCurrent.Base(), &iSlot))
 		return;
+
+	if(!iSlot || g_flTeleportSpread <= 0.0f)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	float vecOffset[2];
+	CTeleportBatch::SpreadOffset(iSlot, g_flTeleportSpread, vecOffset);
+
+	// Only spread where a standing player fits all the way from the destination, brush entities
+	// (doors, elevators, func_brush) included, and has ground within a step below
+	Vector vecDest = *pDest;
+	Vector vecSpread(vecDest.x + vecOffset[0], vecDest.y + vecOffset[1], vecDest.z);
+	Vector vecMins(-16.0f, -16.0f, 0.0f), vecMaxs(16.0f, 16.0f, 72.0f);
+
+	CTraceFilterSkipPlayers filter;
+	Ray_t ray;
+	trace_t tr;
+	ray.Init(vecDest, vecSpread, vecMins, vecMaxs);
+	enginetrace->TraceRay(ray, MASK_PLAYERSOLID, &filter, &tr);
+	if(tr.startsolid || tr.fraction < 1.0f)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	ray.Init(vecSpread, Vector(vecSpread.x, vecSpread.y, vecSpread.z - TELEPORT_STEP_HEIGHT), vecMins, vecMaxs);
+	enginetrace->TraceRay(ray, MASK_PLAYERSOLID, &filter, &tr);
+	if(tr.startsolid || tr.fraction >= 1.0f)
+		return DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+
+	g_TeleportBatch.m_nSpread++;
+	g_TeleportBatch.Landed(iTarget, vecSpread.Base());
+
+	*pDest = vecSpread;
+	DETOUR_MEMBER_CALL(DETOUR_PointTeleportInput)(inputdata);
+	*pDest = vecDest;
+}
+
+#define VIEWCONTROL_USE_ON 1	// CTriggerCamera::m_state
+
+// CBaseEntity::SetTransmitState
+int SetEdictTransmitState(CBaseEntity *pEntity, int nFlag)
+{
+	edict_t *pEdict = gamehelpers->BaseEntityToEdict(pEntity);
+	if(!pEdict)
+		return 0;
+
+	int nOldFlags = pEdict->m_fStateFlags;
+	pEdict->ClearTransmitState();
+	pEdict->m_fStateFlags |= nFlag;
+
+	if((nOldFlags & FL_EDICT_DONTSEND) != (pEdict->m_fStateFlags & FL_EDICT_DONTSEND))
+		engine->NotifyEdictFlagsChange(gamehelpers->IndexOfEdict(pEdict));
+
+	return pEdict->m_fStateFlags;
+}
+
+/* point_viewcontrol: an enabled camera is FL_EDICT_ALWAYS, every client gets every camera of a cutscene.
+ * Switch them to a full check and decide per client in ShouldTransmit below. */
+DETOUR_DECL_MEMBER0(DETOUR_ViewControlUpdateTransmitState, int)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_UpdateTransmitState);
+	if(!g_bViewControlTransmit || g_SvAlwaysTransmitPointViewControl->GetInt())
+		return DETOUR_MEMBER_CALL(DETOUR_ViewControlUpdateTransmitState)();
+
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+	g_pViewControlVTable = *(void **)pEntity;
+
+	int iState = *(int *)((uint8_t *)pEntity + g_Offsets.m_state);
+	return SetEdictTransmitState(pEntity, iState == VIEWCONTROL_USE_ON ? FL_EDICT_FULLCHECK : FL_EDICT_DONTSEND);
+}
+
+DETOUR_DECL_MEMBER1(DETOUR_ShouldTransmit, int, const CCheckTransmitInfo *, pInfo)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_ShouldTransmit);
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+	if(*(void **)pEntity != g_pViewControlVTable || !g_bViewControlTransmit)
+		return DETOUR_MEMBER_CALL(DETOUR_ShouldTransmit)(pInfo);
+
+	g_nViewControlChecks++;
+
+	// Disabled without going through UpdateTransmitState
+	if(*(int *)((uint8_t *)pEntity + g_Offsets.m_state) != VIEWCONTROL_USE_ON)
+		return FL_EDICT_DONTSEND;
+
+	int iClient = gamehelpers->IndexOfEdict(pInfo->m_pClientEnt);
+	if(iClient < 1 || iClient > g_iMaxPlayers)
+		return FL_EDICT_DONTSEND;
+
+	bool bSend = g_bViewControlDebug[iClient];
+
+	// The player that enabled it
+	if(!bSend)
+		bSend = gamehelpers->GetHandleEntity(*(CBaseHandle *)((uint8_t *)pEntity + g_Offsets.m_hPlayer)) == pInfo->m_pClientEnt;
+
+	// Players still looking through it after someone else enabled it again
+	if(!bSend)
+	{
+		CBaseEntity *pClient = gamehelpers->ReferenceToEntity(iClient);
+		bSend = pClient && gamehelpers->GetHandleEntity(*(CBaseHandle *)((uint8_t *)pClient + g_Offsets.m_hViewEntity)) == gamehelpers->BaseEntityToEdict(pEntity);
+	}
+
+	if(!bSend)
+		return FL_EDICT_DONTSEND;
+
+	g_nViewControlSent++;
+	return FL_EDICT_ALWAYS;
+}
+
+#define TICK_NEVER_THINK (-1)	// baseentity.h
+
+/* game_ui: Think polls the player's buttons every tick just to fire outputs when they change.
+ * While nothing would change, stop thinking and let the player's usercmds wake it up again.
+ * Patch 0 (FL_ONTRAIN) also lives in CGameUI::Think, its jb/AddFlag call sequence comes after
+ * the player and button checks, far past the prologue bytes this detour moves to its trampoline,
+ * so the pattern is still found in place and the two never touch the same bytes. */
+DETOUR_DECL_MEMBER0(DETOUR_GameUIThink, void)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_GameUIThink);
+	if(!g_bGameUIEvents)
+		return DETOUR_MEMBER_CALL(DETOUR_GameUIThink)();
+
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+
+	// Player gone, forced update or view cone check, the game handles those
+	edict_t *pPlayerEdict = gamehelpers->GetHandleEntity(*(CBaseHandle *)((uint8_t *)pEntity + g_Offsets.m_player));
+	if(!pPlayerEdict || *(bool *)((uint8_t *)pEntity + g_Offsets.m_bForceUpdate) ||
+		*(float *)((uint8_t *)pEntity + g_Offsets.m_flFieldOfView) > -1.0f)
+	{
+		return DETOUR_MEMBER_CALL(DETOUR_GameUIThink)();
+	}
+
+	int iClient = gamehelpers->IndexOfEdict(pPlayerEdict);
+	CBaseEntity *pPlayer = gamehelpers->ReferenceToEntity(iClient);
+	if(!pPlayer || iClient < 1 || iClient > g_iMaxPlayers ||
+		*(int *)((uint8_t *)pPlayer + g_Offsets.m_nButtons) != *(int *)((uint8_t *)pEntity + g_Offsets.m_nLastButtonState))
+	{
+		return DETOUR_MEMBER_CALL(DETOUR_GameUIThink)();
 	}
 
-	// Remove edicts for a bunch of entities that REALLY don't need them
-	for (int i = 0; i < sizeof(pszNonEdicts)/sizeof(*pszNonEdicts); i++)
+	if(!g_ParkedGameUIs.Park(iClient, gamehelpers->EntityToReference(pEntity)))
+		return DETOUR_MEMBER_CALL(DETOUR_GameUIThink)();
+
+	g_nGameUIParked++;
+	g_pSetNextThink(pEntity, TICK_NEVER_THINK, NULL);
+}
+
+DETOUR_DECL_MEMBER2(DETOUR_PlayerRunCommand, void, CUserCmd *, ucmd, IMoveHelper *, moveHelper)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_PlayerRunCommand);
+	DETOUR_MEMBER_CALL(DETOUR_PlayerRunCommand)(ucmd, moveHelper);
+
+	if(!g_ParkedGameUIs.Any())
+		return;
+
+	CBaseEntity *pPlayer = (CBaseEntity *)this;
+	int iClient = gamehelpers->EntityToBCompatRef(pPlayer);
+	if(iClient < 1 || iClient > g_iMaxPlayers || !g_ParkedGameUIs.Count(iClient))
+		return;
+
+	edict_t *pPlayerEdict = gamehelpers->BaseEntityToEdict(pPlayer);
+	int nButtons = *(int *)((uint8_t *)pPlayer + g_Offsets.m_nButtons);
+
+	g_ParkedGameUIs.Visit(iClient, [pPlayerEdict, nButtons](uint32_t iRef) -> bool
+	{
+		CBaseEntity *pEntity = gamehelpers->ReferenceToEntity(iRef);
+		if(!pEntity)
+			return true;
+
+		// Deactivated or taken over by someone else, whoever did that set its think
+		if(gamehelpers->GetHandleEntity(*(CBaseHandle *)((uint8_t *)pEntity + g_Offsets.m_player)) != pPlayerEdict)
+			return true;
+
+		if(*(int *)((uint8_t *)pEntity + g_Offsets.m_nLastButtonState) == nButtons)
+			return false;
+
+		g_nGameUIWoken++;
+		g_pSetNextThink(pEntity, gpGlobals->curtime, NULL);
+		return true;
+	});
+}
+
+// Back to polling, e.g. when sv_cssfixes_gameui_events is turned off
+void WakeParkedGameUIs()
+{
+	for(int i = 1; i < PARKED_CLIENTS; i++)
 	{
-		if (!strcasecmp(szClassname, pszNonEdicts[i]))
+		g_ParkedGameUIs.Visit(i, [](uint32_t iRef) -> bool
 		{
-			*(uint32 *)((intptr_t)pEntity + offset) |= (1<<9); // EFL_SERVER_ONLY
-		}
+			CBaseEntity *pEntity = gamehelpers->ReferenceToEntity(iRef);
+			if(pEntity)
+				g_pSetNextThink(pEntity, gpGlobals->curtime, NULL);
+			return true;
+		});
+	}
+}
+
+DETOUR_DECL_MEMBER1(DETOUR_PostConstructor, void, const char *, szClassname)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_PostConstructor);
+	VPROF_ENTER_SCOPE("CSSFixes::DETOUR_PostConstructor");
+
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+	bool bDemoted = g_pszEdictPressureServerOnly && szClassname == g_pszEdictPressureServerOnly;
+
+	bool bForcedCT;
+	bool bServerOnly = UTIL_FixPostConstructor(&szClassname, g_SvForceCTSpawn->GetInt() != 0, &bForcedCT);
+	if(bDemoted)
+	{
+		g_pszEdictPressureServerOnly = NULL;
+		bServerOnly = true;
+	}
+
+	if(bServerOnly)
+	{
+		*(uint32 *)((intptr_t)pEntity + g_Offsets.m_iEFlags) |= (1<<9); // EFL_SERVER_ONLY
+		g_nEdictsSaved++;
+	}
+
+	if(bForcedCT && g_SvLogs->GetInt())
+	{
+		AsyncLog("Forcing CT spawn");
 	}
 
 	DETOUR_MEMBER_CALL(DETOUR_PostConstructor)(szClassname);
@@ -288,6 +691,8 @@ DETOUR_DECL_MEMBER1(DETOUR_PostConstructor, void, const char *, szClassname)
 // Implementation for custom filter entities
 DETOUR_DECL_MEMBER2(DETOUR_PassesFilterImpl, bool, CBaseEntity*, pCaller, CBaseEntity*, pEntity)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_PassesFilterImpl);
+
 	CBaseEntity* pThisEnt = (CBaseEntity*)this;
 
 	// filter_activator_context: filters activators based on whether they have a given context with a nonzero value
@@ -295,34 +700,14 @@ DETOUR_DECL_MEMBER2(DETOUR_PassesFilterImpl, bool, CBaseEntity*, pCaller, CBaseE
 	// Implemented here because CUtlVectors are not supported in sourcepawn
 	if (!strcasecmp(gamehelpers->GetEntityClassname(pThisEnt), "filter_activator_context"))
 	{
-		static int m_ResponseContexts_offset = 0, m_iszResponseContext_offset = 0;
-
-		if (!m_ResponseContexts_offset && !m_iszResponseContext_offset)
-		{
-			datamap_t *pDataMap = gamehelpers->GetDataMap(pEntity);
-			sm_datatable_info_t info;
-
-			// Both are CBaseEntity members, so the offsets will always be the same across different entity classes
-			gamehelpers->FindDataMapInfo(pDataMap, "m_ResponseContexts", &info);
-			m_ResponseContexts_offset = info.actual_offset;
-
-			gamehelpers->FindDataMapInfo(pDataMap, "m_iszResponseContext", &info);
-			m_iszResponseContext_offset = info.actual_offset;
-		}
-
 		CUtlVector<ResponseContext_t> vecResponseContexts;
-		vecResponseContexts = *(CUtlVector<ResponseContext_t>*)((uint8_t*)pEntity + m_ResponseContexts_offset);
+		vecResponseContexts = *(CUtlVector<ResponseContext_t>*)((uint8_t*)pEntity + g_Offsets.m_ResponseContexts);
 
-		const char *szFilterContext = (*(string_t*)((uint8_t*)pThisEnt + m_iszResponseContext_offset)).ToCStr();
-		const char *szContext;
-		int iContextValue;
+		const char *szFilterContext = (*(string_t*)((uint8_t*)pThisEnt + g_Offsets.m_iszResponseContext)).ToCStr();
 
 		for (int i = 0; i < vecResponseContexts.Count(); i++)
 		{
-			szContext = vecResponseContexts[i].m_iszName.ToCStr();
-			iContextValue = atoi(vecResponseContexts[i].m_iszValue.ToCStr());
-
-			if (!strcasecmp(szFilterContext, szContext) && iContextValue > 0)
+			if (UTIL_ContextPasses(szFilterContext, vecResponseContexts[i].m_iszName.ToCStr(), vecResponseContexts[i].m_iszValue.ToCStr()))
 				return true;
 		}
 
@@ -336,13 +721,67 @@ DETOUR_DECL_MEMBER2(DETOUR_PassesFilterImpl, bool, CBaseEntity*, pCaller, CBaseE
 // Switch new entity classnames to ones that can be instantiated while keeping the classname keyvalue intact so it can be used later
 DETOUR_DECL_STATIC2(DETOUR_CreateEntityByName, CBaseEntity*, const char*, className, int, iForceEdictIndex)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_CreateEntityByName);
 	VPROF_ENTER_SCOPE("CSSFixes::DETOUR_CreateEntityByName");
 
-	// Nice of valve to expose CBaseFilter as filter_base :)
-	if (strcasecmp(className, "filter_activator_context") == 0)
-		className = "filter_base";
+	const char *szRequestedClassName = className;
+
+	const char *pszCreateName;
+	FactoryCacheEntry *pEntry = g_FactoryCache.Find(className);
+	if (pEntry)
+		pszCreateName = pEntry->pszCreateName;
+	else
+	{
+		pszCreateName = UTIL_RemapClassname(className);
+		void *pFactory = g_pEntityFactoryDictionary->FindFactory(pszCreateName ? pszCreateName : className);
+
+		// Unknown classes aren't remembered, a factory for them can still be installed
+		if (pFactory)
+			pEntry = g_FactoryCache.Add(className, pszCreateName, pFactory);
+	}
+
+	if (pszCreateName)
+		className = pszCreateName;
+
+	const char *pszPrevServerOnly = g_pszEdictPressureServerOnly;
+	g_pszEdictPressureServerOnly = NULL;
+
+	// Close to "no free edicts", cosmetic spawns go without an edict or not at all
+	if (g_EdictPressure.IsEnabled() && iForceEdictIndex == -1 && g_EdictPressureClasses.Contains(szRequestedClassName))
+	{
+		switch (g_EdictPressure.Check(gpGlobals->tickcount, engine->GetEntityCount()))
+		{
+		case EdictPressure_Refuse:
+			g_pszEdictPressureServerOnly = pszPrevServerOnly;
+			VPROF_EXIT_SCOPE();
+			return NULL;
+
+		case EdictPressure_ServerOnly:
+			g_pszEdictPressureServerOnly = className;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (pEntry)
+		pEntry->nCreated++;
+
+	// Same as the engine minus the dictionary lookup, forced edict indices need its CreateEdict dance
+	CBaseEntity *pEntity;
+	if (pEntry && iForceEdictIndex == -1 && g_SvFactoryCache->GetBool())
+	{
+		IServerNetworkable *pNetworkable = ((IEntityFactory *)pEntry->pFactory)->Create(className);
+		pEntity = pNetworkable ? pNetworkable->GetBaseEntity() : NULL;
+	}
+	else
+		pEntity = DETOUR_STATIC_CALL(DETOUR_CreateEntityByName)(className, iForceEdictIndex);
+
+	g_pszEdictPressureServerOnly = pszPrevServerOnly;
 
-	CBaseEntity *pEntity = DETOUR_STATIC_CALL(DETOUR_CreateEntityByName)(className, iForceEdictIndex);
+	if (pEntity && g_SpawnCapture.IsOpen())
+		g_SpawnCapture.Create(pEntity, szRequestedClassName, gpGlobals->tickcount);
 
 	VPROF_EXIT_SCOPE();
 
@@ -351,58 +790,57 @@ DETOUR_DECL_STATIC2(DETOUR_CreateEntityByName, CBaseEntity*, const char*, classN
 
 DETOUR_DECL_MEMBER2(DETOUR_KeyValue, bool, const char *, szKeyName, const char *, szValue)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_KeyValue);
 	VPROF_ENTER_SCOPE("CSSFixes::DETOUR_KeyValue");
 
 	CBaseEntity *pEntity = (CBaseEntity *)this;
 
-	// Fix crash bug in engine
-	if(strcasecmp(szKeyName, "angle") == 0)
+	if (g_SpawnCapture.IsOpen())
+		g_SpawnCapture.KeyValue(pEntity, gamehelpers->GetEntityClassname(pEntity), szKeyName, szValue, gpGlobals->tickcount);
+
+	// User rules go first, the fixes below still apply to whatever they produce
+	if (g_KeyValueRules.Apply(gamehelpers->GetEntityClassname(pEntity), &szKeyName, &szValue) == KeyValueRule_Drop)
 	{
-		szKeyName = "angles";
+		VPROF_EXIT_SCOPE();
+		return true;
 	}
-	else if(g_SvForceCTSpawn->GetInt() &&
-		strcasecmp(szKeyName, "classname") == 0 &&
-		strcasecmp(szValue, "info_player_terrorist") == 0)
+
+	switch(UTIL_FixKeyValue(&szKeyName, &szValue, g_SvForceCTSpawn->GetInt() != 0))
 	{
+	case KeyValueFix_CTSpawn:
 		if (g_SvLogs->GetInt())
 		{
-			g_pSM->LogMessage(myself, "Forcing CT spawn");
+			AsyncLog("Forcing CT spawn");
 		}
+		break;
 
-		// Only CT spawnpoints
-		szValue = "info_player_counterterrorist";
-	}
-	else if(g_SvForceCTSpawn->GetInt() && (strcasecmp(szKeyName, "teamnum") == 0 || strcasecmp(szKeyName, "teamnum") == 0))
+	case KeyValueFix_BuyzoneTeam:
 	{
 		const char *pClassname = gamehelpers->GetEntityClassname(pEntity);
 
 		if (g_SvLogs->GetInt())
 		{
-			g_pSM->LogMessage(myself, "Forcing CT buyzone");
+			AsyncLog("Forcing CT buyzone");
 		}
 
 		// All buyzones should be CT buyzones
 		if(pClassname && strcasecmp(pClassname, "func_buyzone") == 0)
 			szValue = "3";
+		break;
 	}
-	else if(strcasecmp(szKeyName, "absvelocity") == 0)
-	{
-		static int m_AbsVelocity_offset = 0;
-
-		if (!m_AbsVelocity_offset)
-		{
-			datamap_t *pDataMap = gamehelpers->GetDataMap(pEntity);
-			sm_datatable_info_t info;
-
-			gamehelpers->FindDataMapInfo(pDataMap, "m_vecAbsVelocity", &info);
-			m_AbsVelocity_offset = info.actual_offset;
-		}
 
+	case KeyValueFix_AbsVelocity:
+	{
 		float tmp[3];
 		UTIL_StringToVector(tmp, szValue);
 
-		Vector *vecAbsVelocity = (Vector*)((uint8_t*)pEntity + m_AbsVelocity_offset);
+		Vector *vecAbsVelocity = (Vector*)((uint8_t*)pEntity + g_Offsets.m_vecAbsVelocity);
 		vecAbsVelocity->Init(tmp[0], tmp[1], tmp[2]);
+		break;
+	}
+
+	default:
+		break;
 	}
 
 	bool bHandled = DETOUR_MEMBER_CALL(DETOUR_KeyValue)(szKeyName, szValue);
@@ -414,16 +852,107 @@ DETOUR_DECL_MEMBER2(DETOUR_KeyValue, bool, const char *, szKeyName, const char *
 
 /* Ignore players in +USE trace */
 bool g_InFindUseEntity = false;
+
+/* Cache +USE results and rate limit FindUseEntity per player */
+struct UseCache
+{
+	int iTick;				// tick of the last real FindUseEntity, 0 = nothing cached
+	bool bHasTarget;
+	cell_t hTarget;			// serialized reference of the last +USE target
+	Vector vecEyePosition;
+	QAngle angEyeAngles;
+	float flWindowStart;	// start of the current rate limit window
+	int nWindowCalls;		// real FindUseEntity calls in the current window
+} g_UseCache[SM_MAXPLAYERS + 1];
+
+static inline float AngleDiff(float a, float b)
+{
+	float d = fmodf(a - b, 360.0f);
+	if(d > 180.0f)
+		d -= 360.0f;
+	else if(d < -180.0f)
+		d += 360.0f;
+	return fabsf(d);
+}
+
 DETOUR_DECL_MEMBER0(DETOUR_FindUseEntity, CBaseEntity *)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_FindUseEntity);
+
+	int iCacheTicks = g_SvUseCacheTicks->GetInt();
+	int iMaxPerSecond = g_SvUseMaxPerSecond->GetInt();
+	int client = ((IServerUnknown *)this)->GetRefEHandle().GetEntryIndex();
+	edict_t *pEdict = NULL;
+	IPlayerInfo *pInfo = NULL;
+
+	if((iCacheTicks > 0 || iMaxPerSecond > 0) && client >= 1 && client <= g_iMaxPlayers)
+	{
+		IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(client);
+		if(pPlayer && (pEdict = pPlayer->GetEdict()))
+			pInfo = pPlayer->GetPlayerInfo();
+	}
+
+	if(!pInfo)
+	{
+		// Signal CTraceFilterSimple that we are in FindUseEntity
+		g_InFindUseEntity = true;
+		CBaseEntity *pEntity = DETOUR_MEMBER_CALL(DETOUR_FindUseEntity)();
+		g_InFindUseEntity = false;
+		return pEntity;
+	}
+
+	UseCache *pCache = &g_UseCache[client];
+
+	// CBaseEntity::EyePosition, where the +USE trace starts
+	Vector vecEyePosition = pInfo->GetAbsOrigin() + *(Vector *)((uint8_t *)this + g_Offsets.m_vecViewOffset);
+	QAngle angEyeAngles = pInfo->GetLastUserCommand().viewangles;
+
+	float flMaxDistance = g_SvUseCacheDistance->GetFloat();
+	float flMaxAngle = g_SvUseCacheAngle->GetFloat();
+	bool bSameView = pCache->iTick &&
+		vecEyePosition.DistToSqr(pCache->vecEyePosition) <= flMaxDistance * flMaxDistance &&
+		AngleDiff(angEyeAngles.x, pCache->angEyeAngles.x) <= flMaxAngle &&
+		AngleDiff(angEyeAngles.y, pCache->angEyeAngles.y) <= flMaxAngle;
+
+	bool bRateLimited = false;
+	if(iMaxPerSecond > 0)
+	{
+		if(gpGlobals->curtime - pCache->flWindowStart >= 1.0f || gpGlobals->curtime < pCache->flWindowStart)
+		{
+			pCache->flWindowStart = gpGlobals->curtime;
+			pCache->nWindowCalls = 0;
+		}
+		bRateLimited = pCache->nWindowCalls >= iMaxPerSecond;
+	}
+
+	// Over the limit the player keeps the last target, even if the view moved
+	if(bRateLimited || (iCacheTicks > 0 && bSameView && gpGlobals->tickcount - pCache->iTick <= iCacheTicks))
+	{
+		if(!pCache->bHasTarget)
+			return NULL;
+
+		return gamehelpers->ReferenceToEntity(pCache->hTarget);
+	}
+
 	// Signal CTraceFilterSimple that we are in FindUseEntity
 	g_InFindUseEntity = true;
 	CBaseEntity *pEntity = DETOUR_MEMBER_CALL(DETOUR_FindUseEntity)();
 	g_InFindUseEntity = false;
+
+	pCache->nWindowCalls++;
+	pCache->iTick = gpGlobals->tickcount;
+	pCache->vecEyePosition = vecEyePosition;
+	pCache->angEyeAngles = angEyeAngles;
+	pCache->bHasTarget = pEntity != NULL;
+	if(pEntity)
+		pCache->hTarget = gamehelpers->EntityToReference(pEntity);
+
 	return pEntity;
 }
 DETOUR_DECL_MEMBER3(DETOUR_CTraceFilterSimple, void, const IHandleEntity *, passedict, int, collisionGroup, ShouldHitFunc_t, pExtraShouldHitFunc)
 {
+	HOOK_PROFILE_SCOPE(HookProfile_CTraceFilterSimple);
+
 	DETOUR_MEMBER_CALL(DETOUR_CTraceFilterSimple)(passedict, collisionGroup, pExtraShouldHitFunc);
 
 	// If we're in FindUseEntity right now then switch out the VTable
@@ -431,141 +960,1039 @@ DETOUR_DECL_MEMBER3(DETOUR_CTraceFilterSimple, void, const IHandleEntity *, pass
 		*(uintptr_t *)this = g_CTraceFilterNoNPCsOrPlayer;
 }
 
-/* Make bullets ignore teammates */
-char *g_pPhysboxToClientMap = NULL;
-bool g_InFireBullets = false;
-int g_FireBulletPlayerTeam = 0;
-SH_DECL_HOOK2(CTraceFilterSkipTwoEntities, ShouldHitEntity, SH_NOATTRIB, 0, bool, IHandleEntity *, int);
-SH_DECL_HOOK2(CTraceFilterSimple, ShouldHitEntity, SH_NOATTRIB, 0, bool, IHandleEntity *, int);
-bool ShouldHitEntity(IHandleEntity *pHandleEntity, int contentsMask)
+/* Make bullets ignore teammates */
+char *g_pPhysboxToClientMap = NULL;
+bool g_InFireBullets = false;
+int g_FireBulletPlayerTeam = 0;
+int g_FireBulletPlayerIndex = 0;
+
+// Row = attacker, bit (victim - 1) set = attacker's bullets and knife pass through victim
+uint64_t g_PassThroughMatrix[SM_MAXPLAYERS + 1];
+
+SH_DECL_HOOK2(CTraceFilterSkipTwoEntities, ShouldHitEntity, SH_NOATTRIB, 0, bool, IHandleEntity *, int);
+SH_DECL_HOOK2(CTraceFilterSimple, ShouldHitEntity, SH_NOATTRIB, 0, bool, IHandleEntity *, int);
+bool ShouldHitEntity(IHandleEntity *pHandleEntity, int contentsMask)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_ShouldHitEntity);
+
+	if(!g_InFireBullets)
+		RETURN_META_VALUE(MRES_IGNORED, true);
+
+	if(META_RESULT_ORIG_RET(bool) == false)
+		RETURN_META_VALUE(MRES_IGNORED, false);
+
+	IServerUnknown *pUnk = (IServerUnknown *)pHandleEntity;
+	CBaseHandle hndl = pUnk->GetRefEHandle();
+	int index = hndl.GetEntryIndex();
+
+	g_nTraceFilterChecks++;
+
+	bool bPassThrough = UTIL_BulletPassesThrough(index, g_iMaxPlayers, g_pPhysboxToClientMap,
+		g_FireBulletPlayerIndex, g_FireBulletPlayerTeam, g_PassThroughMatrix,
+		[pHandleEntity](int client, int *pTeam, char *pLifeState) -> bool
+	{
+		IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(client);
+		if(!pPlayer || !pPlayer->GetEdict())
+			return false;
+
+		IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
+		if(!pInfo)
+			return false;
+
+		*pTeam = pInfo->GetTeamIndex();
+
+		*pLifeState = *(char *)((uint8_t *)pHandleEntity + g_Offsets.m_lifeState);
+		return true;
+	});
+
+	if(bPassThrough)
+	{
+		g_nTraceFilterPassThrough++;
+		RETURN_META_VALUE(MRES_SUPERCEDE, false);
+	}
+
+	RETURN_META_VALUE(MRES_IGNORED, true);
+}
+
+DETOUR_DECL_STATIC9(DETOUR_FireBullets, void, int, iPlayerIndex, const Vector *, vOrigin, const QAngle *, vAngles, int, iWeaponID, int, iMode, int, iSeed, float, flSpread, float, _f1, float, _f2)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_FireBullets);
+
+	if(iPlayerIndex <= 0 || iPlayerIndex > playerhelpers->GetMaxClients())
+		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+
+	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(iPlayerIndex);
+	if(!pPlayer || !pPlayer->GetEdict())
+		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+
+	IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
+	if(!pInfo)
+		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+
+	g_FireBulletPlayerTeam = pInfo->GetTeamIndex();
+	g_FireBulletPlayerIndex = iPlayerIndex;
+
+	g_InFireBullets = true;
+	DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+	g_InFireBullets = false;
+}
+
+DETOUR_DECL_MEMBER1(DETOUR_SwingOrStab, bool, bool, bStab)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_SwingOrStab);
+
+	IServerUnknown *pUnk = (IServerUnknown *)this;
+	ServerClass *pClass = pUnk->GetNetworkable()->GetServerClass();
+	if(!g_BaseCombatWeaponTables.Contains(pClass->m_ClassID, pClass->m_pTable))
+		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+
+	CBaseHandle &hndl = *(CBaseHandle *)((uint8_t *)this + g_Offsets.m_hOwnerEntity);
+
+	edict_t *pEdict = gamehelpers->GetHandleEntity(hndl);
+	if(!pEdict)
+		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+
+	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(pEdict);
+	if(!pPlayer || !pPlayer->GetEdict())
+		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+
+	IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
+	if(!pInfo)
+		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+
+	g_FireBulletPlayerTeam = pInfo->GetTeamIndex();
+	g_FireBulletPlayerIndex = pPlayer->GetIndex();
+
+	g_InFireBullets = true;
+	bool bRet = DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+	g_InFireBullets = false;
+
+	return bRet;
+}
+
+/* game_text ends up here, pToPlayer = NULL means all players */
+DETOUR_DECL_STATIC3(DETOUR_UTIL_HudMessage, void, CBaseEntity *, pToPlayer, const hudtextparms_t &, textparms, const char *, pMessage)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_UTIL_HudMessage);
+	if(!g_bHudMsgCoalesce || !pMessage)
+		return DETOUR_STATIC_CALL(DETOUR_UTIL_HudMessage)(pToPlayer, textparms, pMessage);
+
+	int iSlot = 0;
+	int nRecipients = playerhelpers->GetNumPlayers();
+	if(pToPlayer)
+	{
+		iSlot = gamehelpers->EntityToBCompatRef(pToPlayer);
+		nRecipients = 1;
+	}
+
+	// Sent in Hook_GameFramePost
+	if(!g_HudMessages.Queue(iSlot, textparms, pMessage, nRecipients))
+		DETOUR_STATIC_CALL(DETOUR_UTIL_HudMessage)(pToPlayer, textparms, pMessage);
+}
+
+void SendHudMessage(int iSlot, const hudtextparms_t &params, const char *pszText)
+{
+	CBaseEntity *pPlayer = NULL;
+	if(iSlot)
+	{
+		IGamePlayer *pGamePlayer = playerhelpers->GetGamePlayer(iSlot);
+		if(!pGamePlayer || !pGamePlayer->IsInGame())
+			return;
+
+		pPlayer = gamehelpers->ReferenceToEntity(iSlot);
+		if(!pPlayer)
+			return;
+	}
+
+	DETOUR_STATIC_CALL(DETOUR_UTIL_HudMessage)(pPlayer, params, pszText);
+}
+
+const char *UTIL_EntityName(CBaseEntity *pEntity)
+{
+	const char *pszName = STRING(*(string_t *)((uint8_t *)pEntity + g_Offsets.m_iName));
+	if(pszName && *pszName)
+		return pszName;
+
+	return gamehelpers->GetEntityClassname(pEntity);
+}
+
+// variant_t has a non trivial copy constructor (CHandle), so it's passed by reference.
+// Only CBaseEntity::AcceptInput is detoured, inputs to classes overriding it aren't traced.
+DETOUR_DECL_MEMBER5(DETOUR_AcceptInput, bool, const char *, szInputName, CBaseEntity *, pActivator, CBaseEntity *, pCaller, variant_hax *, Value, int, outputID)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_AcceptInput);
+	if(!g_bIOTrace)
+		return DETOUR_MEMBER_CALL(DETOUR_AcceptInput)(szInputName, pActivator, pCaller, Value, outputID);
+
+	CBaseEntity *pEntity = (CBaseEntity *)this;
+	IOTraceEvent event = { szInputName, pActivator, pCaller, outputID };
+	IOTrace_Enter(UTIL_EntityName(pEntity), pActivator ? gamehelpers->GetEntityClassname(pActivator) : "", event, gpGlobals->curtime);
+	bool bRet = DETOUR_MEMBER_CALL(DETOUR_AcceptInput)(szInputName, pActivator, pCaller, Value, outputID);
+	IOTrace_Leave();
+
+	return bRet;
+}
+
+// Packets from NA_IP sources only, 0 for loopback and the like
+uint32_t UTIL_PacketAddress(netpacket_hax *packet)
+{
+	if(packet->type != 3) // NA_IP
+		return 0;
+
+	return ((uint32_t)packet->ip[0] << 24) | ((uint32_t)packet->ip[1] << 16) | ((uint32_t)packet->ip[2] << 8) | packet->ip[3];
+}
+
+// Source addresses are spoofable, a connected client's one is never blocked so it can't be locked out
+bool UTIL_IsClientAddress(uint32_t nAddress)
+{
+	for(int i = 1; i <= g_iMaxPlayers; i++)
+	{
+		if(g_ClientAddress[i] == nAddress)
+			return true;
+	}
+
+	return false;
+}
+
+/* NET_GetLong also returns false for every split fragment but the last one,
+ * only the ones the engine complained about (patch 11 redirects its Msg calls) count.
+ * A duplicated fragment can be an honest retransmission, that one doesn't.
+ * CNetChan::ProcessPacketHeader failures aren't limited, they only happen on
+ * established channels where a sequence or checksum failure can be forged. */
+DETOUR_DECL_STATIC2(DETOUR_NET_GetLong, bool, int, sock, netpacket_hax *, packet)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_NET_GetLong);
+	uint32_t nAddress;
+	if(!g_bNetLimit || !(nAddress = UTIL_PacketAddress(packet)) || UTIL_IsClientAddress(nAddress))
+		return DETOUR_STATIC_CALL(DETOUR_NET_GetLong)(sock, packet);
+
+	uint32_t nNowMs = (uint32_t)(Plat_FloatTime() * 1000.0);
+	if(g_NetLimiter.IsBlocked(nAddress, nNowMs))
+		return false;
+
+	g_pszNetMsgLast = NULL;
+	bool bRet = DETOUR_STATIC_CALL(DETOUR_NET_GetLong)(sock, packet);
+	if(!bRet && g_pszNetMsgLast && !strstr(g_pszNetMsgLast, "duplicated"))
+		g_NetLimiter.Penalize(nAddress, nNowMs);
+
+	return bRet;
+}
+
+/* The engine only writes the userinfo string table when FillUserInfo returns
+ * something else than the table holds, so a held back update returns the cached one */
+DETOUR_DECL_MEMBER1(DETOUR_FillUserInfo, void, player_info_t &, info)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_FillUserInfo);
+	DETOUR_MEMBER_CALL(DETOUR_FillUserInfo)(info);
+
+	int client = playerhelpers->GetClientOfUserId(info.userID);
+	if(client < 1 || client > g_iMaxPlayers)
+		return;
+
+	UserInfoCache *pCache = &g_UserInfoCache[client];
+	if(pCache->bValid && memcmp(&pCache->info, &info, sizeof(info)) == 0)
+	{
+		pCache->bPending = false;
+		return;
+	}
+
+	double flNow = Plat_FloatTime();
+	float flInterval = g_SvUserInfoInterval->GetFloat();
+	if(pCache->bValid && flInterval > 0.0f && flNow - pCache->flLastUpdate < flInterval)
+	{
+		memcpy(&pCache->pending, &info, sizeof(info));
+		pCache->bPending = true;
+		memcpy(&info, &pCache->info, sizeof(info));
+
+		g_nUserInfoSuppressed++;
+		g_nUserInfoBytesSaved += sizeof(info) * playerhelpers->GetNumPlayers();
+		return;
+	}
+
+	memcpy(&pCache->info, &info, sizeof(info));
+	pCache->bValid = true;
+	pCache->bPending = false;
+	pCache->flLastUpdate = flNow;
+}
+
+void FlushPendingUserInfo(double flNow)
+{
+	float flInterval = g_SvUserInfoInterval->GetFloat();
+	INetworkStringTable *pTable = NULL;
+
+	for(int client = 1; client <= g_iMaxPlayers; client++)
+	{
+		UserInfoCache *pCache = &g_UserInfoCache[client];
+		if(!pCache->bPending || flNow - pCache->flLastUpdate < flInterval)
+			continue;
+
+		if(!pTable && !(pTable = netstringtables->FindTable("userinfo")))
+			return;
+
+		// Userinfo table entries are indexed by client slot
+		memcpy(&pCache->info, &pCache->pending, sizeof(pCache->info));
+		pCache->bPending = false;
+		pCache->flLastUpdate = flNow;
+
+		// Outside of the engine's own updates the string tables are locked
+		bool bSave = engine->LockNetworkStringTables(false);
+		pTable->SetStringUserData(client - 1, sizeof(pCache->info), &pCache->info);
+		engine->LockNetworkStringTables(bSave);
+	}
+}
+
+DETOUR_DECL_MEMBER6(DETOUR_GetFileInfo, bool, const char *, pFilename, int &, nBaseIndex, int64 &, nFileOffset, int &, nOriginalSize, int &, nCompressedSize, unsigned short &, nCompressionMethod)
+{
+	// Neither the cache nor the profiler are thread safe, the async loader goes to the engine
+	if(!ThreadInMainThread())
+		return DETOUR_MEMBER_CALL(DETOUR_GetFileInfo)(pFilename, nBaseIndex, nFileOffset, nOriginalSize, nCompressedSize, nCompressionMethod);
+
+	HOOK_PROFILE_SCOPE(HookProfile_GetFileInfo);
+	if(!g_bPakCache)
+		return DETOUR_MEMBER_CALL(DETOUR_GetFileInfo)(pFilename, nBaseIndex, nFileOffset, nOriginalSize, nCompressedSize, nCompressionMethod);
+
+	PakFileInfo info;
+	if(!g_PakCache.Lookup(this, pFilename, &info))
+	{
+		info.bFound = DETOUR_MEMBER_CALL(DETOUR_GetFileInfo)(pFilename, nBaseIndex, nFileOffset, nOriginalSize, nCompressedSize, nCompressionMethod);
+		if(info.bFound)
+		{
+			info.nBaseIndex = nBaseIndex;
+			info.nFileOffset = nFileOffset;
+			info.nOriginalSize = nOriginalSize;
+			info.nCompressedSize = nCompressedSize;
+			info.nCompressionMethod = nCompressionMethod;
+		}
+
+		g_PakCache.Store(this, pFilename, info);
+		return info.bFound;
+	}
+
+	if(info.bFound)
+	{
+		nBaseIndex = info.nBaseIndex;
+		nFileOffset = info.nFileOffset;
+		nOriginalSize = info.nOriginalSize;
+		nCompressedSize = info.nCompressedSize;
+		nCompressionMethod = info.nCompressionMethod;
+	}
+
+	return info.bFound;
+}
+
+void UTIL_VariantCoalesceKey(variant_hax *Value, CoalesceKey *pKey)
+{
+	variant_full_hax *pValue = (variant_full_hax *)Value;
+
+	pKey->iValueType = pValue->fieldType;
+	memset(pKey->value, 0, sizeof(pKey->value));
+
+	// Only compare the bytes the type uses, the rest of the union is uninitialized
+	switch(pValue->fieldType)
+	{
+		case FIELD_VOID:
+			break;
+		case FIELD_BOOLEAN:
+		case FIELD_CHARACTER:
+			pKey->value[0] = pValue->data[0];
+			break;
+		case FIELD_SHORT:
+			memcpy(pKey->value, pValue->data, 2);
+			break;
+		case FIELD_VECTOR:
+		case FIELD_POSITION_VECTOR:
+			memcpy(pKey->value, pValue->data, 12);
+			break;
+		case FIELD_EHANDLE:
+			memcpy(pKey->value, &pValue->eVal, sizeof(pValue->eVal));
+			break;
+		default:
+			memcpy(pKey->value, pValue->data, 4);
+			break;
+	}
+}
+
+DETOUR_DECL_MEMBER7(DETOUR_AddEvent, void, const char *, target, const char *, targetInput, variant_hax *, Value, float, fireDelay, CBaseEntity *, pActivator, CBaseEntity *, pCaller, int, outputID)
+{
+	HOOK_PROFILE_SCOPE(HookProfile_AddEvent);
+	// Inputs that aren't dropped still have to be seen, they break up runs of identical ones
+	if(g_bCoalesceEvents && target && targetInput && Coalesce_IsTracked(targetInput))
+	{
+		CoalesceKey key;
+		key.pszTarget = target;
+		key.pszInput = targetInput;
+		key.pCaller = pCaller;
+		// !activator, !caller, !self... resolve through the activator
+		key.pActivator = target[0] == '!' ? pActivator : NULL;
+		key.flFireTime = gpGlobals->curtime + fireDelay;
+		UTIL_VariantCoalesceKey(Value, &key);
+
+		if(Coalesce_Check(gpGlobals->tickcount, key))
+			return;
+	}
+	else if(g_bCoalesceEvents && target)
+	{
+		// Anything else may touch the same state, SetSpeedReal between two SetSpeed
+		Coalesce_Break(gpGlobals->tickcount, target);
+	}
+
+	// The event queue hands the same input string, activator, caller and output id to AcceptInput
+	if(g_bIOTrace)
+	{
+		IOTraceEvent event = { targetInput, pActivator, pCaller, outputID };
+		IOTrace_Output(event, gpGlobals->curtime, gpGlobals->curtime + fireDelay);
+	}
+
+	DETOUR_MEMBER_CALL(DETOUR_AddEvent)(target, targetInput, Value, fireDelay, pActivator, pCaller, outputID);
+}
+
+void DumpIOTrace(bool bLog)
+{
+	int nMax = clamp(g_SvIOTraceTop->GetInt(), 1, 100);
+	const IOTraceEntry *pTop[100];
+	int nCount = IOTrace_Top(pTop, nMax);
+
+	char szLine[512];
+	snprintf(szLine, sizeof(szLine), "I/O trace: %llu inputs, %llu outputs queued, %u untraced, %u queued outputs that start a new chain (side table full)",
+		(unsigned long long)g_nIOTraceInputs, (unsigned long long)g_nIOTraceOutputs, g_nIOTraceDropped, g_nIOTraceUncarried);
+	if(bLog)
+		g_pSM->LogMessage(myself, "%s", szLine);
+	else
+		META_CONPRINTF("%s\n", szLine);
+
+	for(int i = 0; i < nCount; i++)
+	{
+		const IOTraceEntry *pEntry = pTop[i];
+		snprintf(szLine, sizeof(szLine), "%2d. %s.%s: %u calls, %.3f ms self, %.3f ms total, fan-out %u, depth %u, origin %s (%s)",
+			i + 1, pEntry->szTarget, pEntry->szInput, pEntry->nCalls,
+			HookProfile_CyclesToMicroseconds((double)pEntry->nSelfCycles) / 1000.0,
+			HookProfile_CyclesToMicroseconds((double)pEntry->nCycles) / 1000.0,
+			pEntry->nFanOut, pEntry->nMaxDepth, pEntry->szOrigin,
+			pEntry->szActivator[0] ? pEntry->szActivator : "no activator");
+
+		if(bLog)
+			g_pSM->LogMessage(myself, "%s", szLine);
+		else
+			META_CONPRINTF("%s\n", szLine);
+	}
+}
+
+class CRoundStartListener : public IGameEventListener2
+{
+public:
+	virtual void FireGameEvent(IGameEvent *event)
+	{
+		if(!g_bIOTrace)
+			return;
+
+		DumpIOTrace(true);
+		IOTrace_Reset();
+	}
+
+	virtual int GetEventDebugID()
+	{
+		return EVENT_DEBUG_ID_INIT;
+	}
+} g_RoundStartListener;
+
+CON_COMMAND(sm_cssfixes_entities, "Print the most created entity classes this map, pass reset to clear the counts")
+{
+	if(args.ArgC() > 1 && strcasecmp(args.Arg(1), "reset") == 0)
+	{
+		g_FactoryCache.ResetCounts();
+		META_CONPRINTF("[CSSFixes] Entity creation counts reset.\n");
+		return;
+	}
+
+	const FactoryCacheEntry *pTop[32];
+	int nCount = g_FactoryCache.Top(pTop, sizeof(pTop) / sizeof(*pTop));
+
+	META_CONPRINTF("%-40s %12s\n", "classname", "created");
+	for(int i = 0; i < nCount; i++)
+	{
+		META_CONPRINTF("%-40s %12llu\n", pTop[i]->sClassname.c_str(), (unsigned long long)pTop[i]->nCreated);
+	}
+}
+
+CON_COMMAND(sm_cssfixes_io, "Print the most expensive entity inputs since round start, pass reset to clear them")
+{
+	if(args.ArgC() > 1 && strcasecmp(args.Arg(1), "reset") == 0)
+	{
+		IOTrace_Reset();
+		META_CONPRINTF("[CSSFixes] I/O trace reset.\n");
+		return;
+	}
+
+	if(!g_bIOTrace)
+		META_CONPRINTF("[CSSFixes] I/O tracing is disabled, set sv_cssfixes_iotrace 1 to enable it.\n");
+
+	DumpIOTrace(false);
+}
+
+cell_t PhysboxToClientMap(IPluginContext *pContext, const cell_t *params)
+{
+	if(params[2])
+		pContext->LocalToPhysAddr(params[1], (cell_t **)&g_pPhysboxToClientMap);
+	else
+		g_pPhysboxToClientMap = NULL;
+
+	return 0;
+}
+
+cell_t SetPassThrough(IPluginContext *pContext, const cell_t *params)
+{
+	int attacker = params[1];
+	int victim = params[2];
+
+	if(attacker < 1 || attacker > g_iMaxPlayers)
+		return pContext->ThrowNativeError("Invalid attacker index %d", attacker);
+
+	if(victim < 1 || victim > g_iMaxPlayers || victim > PASSTHROUGH_MAXPLAYERS)
+		return pContext->ThrowNativeError("Invalid victim index %d", victim);
+
+	if(params[3])
+		g_PassThroughMatrix[attacker] |= (1ULL << (victim - 1));
+	else
+		g_PassThroughMatrix[attacker] &= ~(1ULL << (victim - 1));
+
+	return 0;
+}
+
+cell_t GetPassThrough(IPluginContext *pContext, const cell_t *params)
+{
+	int attacker = params[1];
+	int victim = params[2];
+
+	if(attacker < 1 || attacker > g_iMaxPlayers)
+		return pContext->ThrowNativeError("Invalid attacker index %d", attacker);
+
+	if(victim < 1 || victim > g_iMaxPlayers || victim > PASSTHROUGH_MAXPLAYERS)
+		return pContext->ThrowNativeError("Invalid victim index %d", victim);
+
+	return !!(g_PassThroughMatrix[attacker] & (1ULL << (victim - 1)));
+}
+
+void ResetPassThrough(int client)
+{
+	g_PassThroughMatrix[client] = 0;
+	if(client > PASSTHROUGH_MAXPLAYERS)
+		return;
+
+	for(int i = 1; i <= SM_MAXPLAYERS; i++)
+		g_PassThroughMatrix[i] &= ~(1ULL << (client - 1));
+}
+
+cell_t ClearPassThrough(IPluginContext *pContext, const cell_t *params)
+{
+	int client = params[1];
+
+	if(client == 0)
+	{
+		memset(g_PassThroughMatrix, 0, sizeof(g_PassThroughMatrix));
+		return 0;
+	}
+
+	if(client < 1 || client > g_iMaxPlayers)
+		return pContext->ThrowNativeError("Invalid client index %d", client);
+
+	ResetPassThrough(client);
+	return 0;
+}
+
+cell_t GetHookProfile(IPluginContext *pContext, const cell_t *params)
+{
+	int hook = params[1];
+	if(hook < 0 || hook >= HookProfile_Count)
+		return pContext->ThrowNativeError("Invalid hook %d", hook);
+
+	HookProfileStats *pStats = &g_HookProfileStats[hook];
+	cell_t *pCalls, *pAvg, *pMin, *pMax, *pP99;
+	pContext->LocalToPhysAddr(params[2], &pCalls);
+	pContext->LocalToPhysAddr(params[3], &pAvg);
+	pContext->LocalToPhysAddr(params[4], &pMin);
+	pContext->LocalToPhysAddr(params[5], &pMax);
+	pContext->LocalToPhysAddr(params[6], &pP99);
+
+	*pCalls = (cell_t)pStats->nCalls;
+	if(!pStats->nCalls)
+	{
+		*pAvg = *pMin = *pMax = *pP99 = sp_ftoc(0.0f);
+		return false;
+	}
+
+	*pAvg = sp_ftoc((float)HookProfile_CyclesToMicroseconds((double)pStats->nTotalCycles / pStats->nCalls));
+	*pMin = sp_ftoc((float)HookProfile_CyclesToMicroseconds((double)pStats->nMinCycles));
+	*pMax = sp_ftoc((float)HookProfile_CyclesToMicroseconds((double)pStats->nMaxCycles));
+	*pP99 = sp_ftoc((float)HookProfile_CyclesToMicroseconds((double)HookProfile_Percentile((HookProfile)hook, 0.99)));
+	return true;
+}
+
+cell_t ResetHookProfile(IPluginContext *pContext, const cell_t *params)
+{
+	HookProfile_Reset();
+	return 0;
+}
+
+cell_t SetViewControlDebug(IPluginContext *pContext, const cell_t *params)
+{
+	int client = params[1];
+
+	if(client < 1 || client > g_iMaxPlayers)
+		return pContext->ThrowNativeError("Invalid client index %d", client);
+
+	g_bViewControlDebug[client] = !!params[2];
+	return 0;
+}
+
+CON_COMMAND(sm_cssfixes_stats, "Print CSSFixes hook profile, pass reset to clear it")
+{
+	if(args.ArgC() > 1 && strcasecmp(args.Arg(1), "reset") == 0)
+	{
+		HookProfile_Reset();
+		META_CONPRINTF("[CSSFixes] Hook profile reset.\n");
+		return;
+	}
+
+	if(!g_bHookStats)
+		META_CONPRINTF("[CSSFixes] Profiling is disabled, set sv_cssfixes_profile 1 to enable it.\n");
+
+	META_CONPRINTF("%-20s %12s %12s %10s %10s %10s %10s\n", "hook", "calls", "total ms", "min us", "avg us", "max us", "p99 us");
+	for(int i = 0; i < HookProfile_Count; i++)
+	{
+		HookProfileStats *pStats = &g_HookProfileStats[i];
+		if(!pStats->nCalls)
+		{
+			META_CONPRINTF("%-20s %12d\n", g_pszHookProfileNames[i], 0);
+			continue;
+		}
+
+		META_CONPRINTF("%-20s %12llu %12.3f %10.3f %10.3f %10.3f %10.3f\n", g_pszHookProfileNames[i],
+			(unsigned long long)pStats->nCalls,
+			HookProfile_CyclesToMicroseconds((double)pStats->nTotalCycles) / 1000.0,
+			HookProfile_CyclesToMicroseconds((double)pStats->nMinCycles),
+			HookProfile_CyclesToMicroseconds((double)pStats->nTotalCycles / pStats->nCalls),
+			HookProfile_CyclesToMicroseconds((double)pStats->nMaxCycles),
+			HookProfile_CyclesToMicroseconds((double)HookProfile_Percentile((HookProfile)i, 0.99)));
+	}
+}
+
+static_assert(HookProfile_Count <= STATSPAGE_MAX_HOOKS, "StatsPage can't hold all hooks");
+void UpdateStatsPage()
+{
+	if(!g_SvStatsPage->GetInt())
+	{
+		if(g_pStatsPage)
+		{
+			StatsPage_Close();
+			g_pStatsPage = NULL;
+		}
+		return;
+	}
+
+	if(!g_pStatsPage)
+	{
+		char path[PLATFORM_MAX_PATH];
+		g_pSM->BuildPath(Path_SM, path, sizeof(path), "data/cssfixes_stats.shm");
+
+		g_pStatsPage = StatsPage_Open(path);
+		if(!g_pStatsPage)
+		{
+			g_pSM->LogError(myself, "Could not map %s, disabling sv_cssfixes_statspage", path);
+			g_SvStatsPage->SetValue(0);
+			return;
+		}
+	}
+
+	StatsPage *pPage = g_pStatsPage;
+	StatsPage_BeginWrite(pPage);
+
+	pPage->nUpdateTime = (int64_t)time(NULL);
+	pPage->iTick = gpGlobals->tickcount;
+	pPage->bProfiling = g_bHookStats;
+	pPage->flMicrosecondsPerCycle = HookProfile_MicrosecondsPerCycle();
+
+	pPage->nHooks = HookProfile_Count;
+	for(int i = 0; i < HookProfile_Count; i++)
+	{
+		StatsPageHook *pHook = &pPage->hooks[i];
+		strncpy(pHook->szName, g_pszHookProfileNames[i], sizeof(pHook->szName) - 1);
+		pHook->nCalls = g_HookProfileStats[i].nCalls;
+		pHook->nTotalCycles = g_HookProfileStats[i].nTotalCycles;
+		pHook->nMaxCycles = g_HookProfileStats[i].nMaxCycles;
+	}
+
+	pPage->nEdictsSaved = g_nEdictsSaved;
+	pPage->nPatches = gs_Patches.size();
+	pPage->nPatchesApplied = g_nPatchesApplied;
+	pPage->nTraceFilterChecks = g_nTraceFilterChecks;
+	pPage->nTraceFilterPassThrough = g_nTraceFilterPassThrough;
+	pPage->nEventsCoalesceChecked = g_nCoalesceChecked;
+	pPage->nEventsCoalesced = g_nCoalesceDropped;
+	pPage->nNetHeaderMessages = g_nNetMsgTotal;
+	pPage->nNetLimitPenalties = g_NetLimiter.m_nPenalties;
+	pPage->nNetLimitDropped = g_NetLimiter.m_nBlocked;
+	pPage->nUserInfoSuppressed = g_nUserInfoSuppressed;
+	pPage->nUserInfoBytesSaved = g_nUserInfoBytesSaved;
+	pPage->nPakCacheHits = g_PakCache.m_nHits;
+	pPage->nPakCacheMisses = g_PakCache.m_nMisses;
+	pPage->nKeyValueRulesChecked = g_KeyValueRules.m_nChecked;
+	pPage->nKeyValueRulesApplied = g_KeyValueRules.m_nApplied;
+	pPage->nFactoryCacheHits = g_FactoryCache.m_nHits;
+	pPage->nFactoryCacheClasses = g_FactoryCache.Count();
+	pPage->nEdicts = engine->GetEntityCount();
+	pPage->nEdictPressureAllowed = g_EdictPressure.m_nAllowed;
+	pPage->nEdictPressureServerOnly = g_EdictPressure.m_nServerOnly;
+	pPage->nEdictPressureRefused = g_EdictPressure.m_nRefused;
+	pPage->nHudMsgQueued = g_HudMessages.m_nQueued;
+	pPage->nHudMsgReplaced = g_HudMessages.m_nReplaced;
+	pPage->nHudMsgSuppressed = g_HudMessages.m_nSuppressed;
+	pPage->nHudMsgBytesSaved = g_HudMessages.m_nBytesSaved;
+	pPage->nCmdQueueDepth = g_CmdQueue.Depth();
+	pPage->nCmdQueueMaxDepth = g_CmdQueue.m_nMaxDepth;
+	pPage->nCmdQueued = g_CmdQueue.m_nQueued;
+	pPage->nCmdDeduplicated = g_CmdQueue.m_nDeduplicated;
+	pPage->nCmdExecuted = g_CmdQueue.m_nExecuted;
+
+	pPage->nTeleports = g_TeleportBatch.m_nTeleports;
+	pPage->nTeleportsBatched = g_TeleportBatch.m_nBatched;
+	pPage->nTeleportsSpread = g_TeleportBatch.m_nSpread;
+	pPage->nTeleportsDeduplicated = g_TeleportBatch.m_nDeduplicated;
+
+	pPage->nViewControlChecks = g_nViewControlChecks;
+	pPage->nViewControlSent = g_nViewControlSent;
+
+	pPage->nGameUIParked = g_nGameUIParked;
+	pPage->nGameUIWoken = g_nGameUIWoken;
+
+	StatsPage_EndWrite(pPage);
+}
+
+void LogNetMsgSummary(int iInterval)
 {
-	if(!g_InFireBullets)
-		RETURN_META_VALUE(MRES_IGNORED, true);
+	if(g_nNetMsgInterval)
+	{
+		AsyncLog("Packet header messages in the last %d seconds: %u, %u without a known source",
+			iInterval, g_nNetMsgInterval, g_nNetMsgUnknown);
 
-	if(META_RESULT_ORIG_RET(bool) == false)
-		RETURN_META_VALUE(MRES_IGNORED, false);
+		const NetMsgSource *pTop[5];
+		int nCount = NetMsg_Top(pTop, 5);
+		for(int i = 0; i < nCount; i++)
+		{
+			AsyncLogString address;
+			uint32_t nAddress = pTop[i]->nAddress;
+			snprintf(address.sz, sizeof(address.sz), "%u.%u.%u.%u",
+				nAddress >> 24, (nAddress >> 16) & 0xFF, (nAddress >> 8) & 0xFF, nAddress & 0xFF);
 
-	IServerUnknown *pUnk = (IServerUnknown *)pHandleEntity;
-	CBaseHandle hndl = pUnk->GetRefEHandle();
-	int index = hndl.GetEntryIndex();
+			AsyncLog("Packet header messages from %s: %u", address, pTop[i]->nCount);
+		}
+	}
+
+	NetMsg_Reset();
+}
 
-	int iTeam = 0;
+void UpdateEdictPressure()
+{
+	g_EdictPressure.Configure(g_SvEdictPressure->GetInt(), g_SvEdictWatermark->GetInt(), g_SvEdictBudget->GetInt());
+	if(g_EdictPressure.IsEnabled())
+		g_EdictPressureClasses.Set(g_SvEdictPressureClasses->GetString());
+}
 
-	if(index > g_iMaxPlayers && g_pPhysboxToClientMap && index < 2048)
+double g_flLastFrameTime = 0.0;
+void OnGameFrame(bool simulating)
+{
+	float flThresholdMs = g_SvFlightRecThreshold->GetFloat();
+	g_bHookStats = g_SvProfile->GetBool();
+	g_bHookProfiling = g_bHookStats || flThresholdMs > 0.0f;
+	g_bIOTrace = g_pDetour_AcceptInput && g_SvIOTrace->GetBool();
+	g_bCoalesceEvents = g_pDetour_AddEvent && g_SvCoalesceEvents->GetBool();
+	g_bNetLimit = g_pDetour_NET_GetLong && g_SvNetLimit->GetBool();
+	UpdateEdictPressure();
+	g_bHudMsgCoalesce = g_pDetour_UTIL_HudMessage && g_SvHudMsgCoalesce->GetBool();
+	g_bCmdQueue = g_pDetour_ServerCommandInput && g_SvCmdQueue->GetBool();
+	g_bTeleportBatch = g_pDetour_PointTeleportInput && g_SvTeleportBatch->GetBool();
+	g_flTeleportSpread = g_SvTeleportSpread->GetFloat();
+	g_bViewControlTransmit = g_pDetour_ViewControlUpdateTransmitState && g_SvViewControlTransmit->GetBool();
+	bool bGameUIEvents = g_pDetour_GameUIThink && g_SvGameUIEvents->GetBool();
+	if(g_bGameUIEvents && !bGameUIEvents)
+		WakeParkedGameUIs();
+	g_bGameUIEvents = bGameUIEvents;
+	if(g_bNetLimit)
+		g_NetLimiter.Configure(g_SvNetLimitBurst->GetFloat(), g_SvNetLimitRefill->GetFloat());
+	if(g_bCoalesceEvents && strcmp(g_szCoalesceInputs, g_SvCoalesceInputs->GetString()) != 0)
 	{
-		index = g_pPhysboxToClientMap[index];
+		strncpy(g_szCoalesceInputs, g_SvCoalesceInputs->GetString(), sizeof(g_szCoalesceInputs) - 1);
+		Coalesce_SetInputs(g_szCoalesceInputs);
 	}
 
-	if(index >= -3 && index <= -1)
+	double flNow = Plat_FloatTime();
+	if(flThresholdMs > 0.0f && g_flLastFrameTime > 0.0)
 	{
-		iTeam = -index;
+		float flFrameMs = (float)((flNow - g_flLastFrameTime) * 1000.0);
+		if(FlightRecorder_RecordFrame(gpGlobals->tickcount, flFrameMs, flThresholdMs, g_SvFlightRecFrames->GetInt()))
+		{
+			char path[PLATFORM_MAX_PATH];
+			const char *map = gpGlobals->mapname.ToCStr();
+			g_pSM->BuildPath(Path_SM, path, sizeof(path), "logs/cssfixes_spike_%s_%d.bin", map, (int)time(NULL));
+
+			if(FlightRecorder_Dump(path, map))
+				g_pSM->LogMessage(myself, "Server frame over %.2f ms, flight recorder written to %s", flThresholdMs, path);
+			else
+				g_pSM->LogError(myself, "Could not write flight recorder to %s", path);
+		}
 	}
-	else if(index < 1 || index > g_iMaxPlayers)
+	else
 	{
-		RETURN_META_VALUE(MRES_IGNORED, true);
+		HookProfile_ResetFrame();
 	}
+	g_flLastFrameTime = flNow;
+
+	FlushPendingUserInfo(flNow);
 
-	char lifeState = 0;
-	if(!iTeam)
+	// Also drains what is left after sv_cssfixes_cmdqueue got turned off
+	if(g_CmdQueue.Depth())
+		g_CmdQueue.Drain(g_SvCmdQueueCommands->GetInt(), ExecuteQueuedCommand);
+
+	static double s_flNextNetMsgSummary = 0.0;
+	int iNetMsgInterval = g_SvNetMsgInterval->GetInt();
+	if(iNetMsgInterval <= 0)
 	{
-		IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(index);
-		if(!pPlayer || !pPlayer->GetEdict())
-			RETURN_META_VALUE(MRES_IGNORED, true);
+		s_flNextNetMsgSummary = 0.0;
+	}
+	else if(flNow >= s_flNextNetMsgSummary)
+	{
+		if(s_flNextNetMsgSummary > 0.0)
+			LogNetMsgSummary(iNetMsgInterval);
+		else
+			NetMsg_Reset();
 
-		IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
-		if(!pInfo)
-			RETURN_META_VALUE(MRES_IGNORED, true);
+		s_flNextNetMsgSummary = flNow + iNetMsgInterval;
+	}
+
+	UpdateStatsPage();
+}
 
-		iTeam = pInfo->GetTeamIndex();
+/**
+ * configs/cssfixes_keyvalues.cfg
+ *
+ * "KeyValueRules"
+ * {
+ *     "<description>"
+ *     {
+ *         "map"        "ze_*"          // optional, default *
+ *         "classname"  "func_door"     // optional, default *
+ *         "key"        "speed"
+ *         "value"      "*"             // optional, default *
+ *         "action"     "set"           // set, rename or drop
+ *         "to"         "200"           // new value for set, new key name for rename
+ *     }
+ * }
+ */
+class CKeyValueRulesParser : public ITextListener_SMC
+{
+public:
+	CKeyValueRulesParser(CKeyValueRules *pRules) : m_pRules(pRules), m_iDepth(0)
+	{
+	}
 
-		static int offset = 0;
-		if(!offset)
+	virtual SMCResult ReadSMC_NewSection(const SMCStates *states, const char *name)
+	{
+		if(++m_iDepth == 2)
 		{
-			sm_sendprop_info_t spi;
-			if (!gamehelpers->FindSendPropInfo("CBasePlayer", "m_lifeState", &spi))
-				RETURN_META_VALUE(MRES_IGNORED, true);
+			m_Rule.sMap = "*";
+			m_Rule.sClassname = "*";
+			m_Rule.sKey.clear();
+			m_Rule.sValue = "*";
+			m_Rule.action = KeyValueRule_None;
+			m_Rule.sTo.clear();
+			m_Name = name;
+		}
+
+		return SMCResult_Continue;
+	}
 
-			offset = spi.actual_offset;
+	virtual SMCResult ReadSMC_KeyValue(const SMCStates *states, const char *key, const char *value)
+	{
+		if(m_iDepth != 2)
+			return SMCResult_Continue;
+
+		if(!strcasecmp(key, "map"))
+			m_Rule.sMap = value;
+		else if(!strcasecmp(key, "classname"))
+			m_Rule.sClassname = value;
+		else if(!strcasecmp(key, "key"))
+			m_Rule.sKey = value;
+		else if(!strcasecmp(key, "value"))
+			m_Rule.sValue = value;
+		else if(!strcasecmp(key, "to"))
+			m_Rule.sTo = value;
+		else if(!strcasecmp(key, "action"))
+		{
+			if(!strcasecmp(value, "set"))
+				m_Rule.action = KeyValueRule_Set;
+			else if(!strcasecmp(value, "rename"))
+				m_Rule.action = KeyValueRule_Rename;
+			else if(!strcasecmp(value, "drop"))
+				m_Rule.action = KeyValueRule_Drop;
 		}
 
-		lifeState = *(char *)((uint8_t *)pHandleEntity + offset);
+		return SMCResult_Continue;
 	}
 
-	if(iTeam == g_FireBulletPlayerTeam || lifeState != 0)
-		RETURN_META_VALUE(MRES_SUPERCEDE, false);
+	virtual SMCResult ReadSMC_LeavingSection(const SMCStates *states)
+	{
+		if(m_iDepth-- != 2)
+			return SMCResult_Continue;
 
-	RETURN_META_VALUE(MRES_IGNORED, true);
-}
+		if(m_Rule.sKey.empty() || m_Rule.action == KeyValueRule_None ||
+			(m_Rule.action != KeyValueRule_Drop && m_Rule.sTo.empty()))
+		{
+			g_pSM->LogError(myself, "Keyvalue rule \"%s\" (line %d) needs a key, an action and for set/rename a \"to\" value, skipping it",
+				m_Name.c_str(), states->line);
+			return SMCResult_Continue;
+		}
 
-DETOUR_DECL_STATIC9(DETOUR_FireBullets, void, int, iPlayerIndex, const Vector *, vOrigin, const QAngle *, vAngles, int, iWeaponID, int, iMode, int, iSeed, float, flSpread, float, _f1, float, _f2)
+		m_pRules->Add(m_Rule);
+		return SMCResult_Continue;
+	}
+
+private:
+	CKeyValueRules *m_pRules;
+	int m_iDepth;
+	KeyValueRule m_Rule;
+	std::string m_Name;
+};
+
+void LoadKeyValueRules(const char *pMapName)
 {
-	if(iPlayerIndex <= 0 || iPlayerIndex > playerhelpers->GetMaxClients())
-		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+	g_KeyValueRules.Clear();
+	if(!g_SvKeyValueRules->GetBool())
+	{
+		g_KeyValueRules.Compile(pMapName);
+		return;
+	}
 
-	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(iPlayerIndex);
-	if(!pPlayer || !pPlayer->GetEdict())
-		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+	char path[PLATFORM_MAX_PATH];
+	g_pSM->BuildPath(Path_SM, path, sizeof(path), "configs/cssfixes_keyvalues.cfg");
 
-	IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
-	if(!pInfo)
-		return DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
+	CKeyValueRulesParser parser(&g_KeyValueRules);
+	SMCStates states;
+	SMCError err = textparsers->ParseFile_SMC(path, &parser, &states);
 
-	g_FireBulletPlayerTeam = pInfo->GetTeamIndex();
+	// No config, no rules
+	if(err != SMCError_Okay && err != SMCError_StreamOpen)
+	{
+		g_pSM->LogError(myself, "Could not parse %s (line %d): %s", path, states.line, textparsers->GetSMCErrorString(err));
+		g_KeyValueRules.Clear();
+	}
 
-	g_InFireBullets = true;
-	DETOUR_STATIC_CALL(DETOUR_FireBullets)(iPlayerIndex, vOrigin, vAngles, iWeaponID, iMode, iSeed, flSpread, _f1, _f2);
-	g_InFireBullets = false;
+	size_t nRules = g_KeyValueRules.Compile(pMapName);
+	if(nRules)
+		g_pSM->LogMessage(myself, "%u of %u keyvalue rules apply to %s", (unsigned)nRules, (unsigned)g_KeyValueRules.Count(), pMapName);
 }
 
-DETOUR_DECL_MEMBER1(DETOUR_SwingOrStab, bool, bool, bStab)
+SH_DECL_HOOK1_void(IServerGameDLL, GameFrame, SH_NOATTRIB, 0, bool);
+
+// Everything the entities queued this tick, before the engine sends the frame
+void Hook_GameFramePost(bool simulating)
 {
-	static int offset = 0;
-	if(!offset)
-	{
-		IServerUnknown *pUnk = (IServerUnknown *)this;
-		IServerNetworkable *pNet = pUnk->GetNetworkable();
+	g_HudMessages.Flush(gpGlobals->curtime, playerhelpers->GetNumPlayers(), SendHudMessage);
+
+	RETURN_META(MRES_IGNORED);
+}
 
-		if (!UTIL_ContainsDataTable(pNet->GetServerClass()->m_pTable, "DT_BaseCombatWeapon"))
-			return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+SH_DECL_HOOK6(IServerGameDLL, LevelInit, SH_NOATTRIB, 0, bool, char const *, char const *, char const *, char const *, bool, bool);
+SH_DECL_HOOK0_void(IServerGameDLL, LevelShutdown, SH_NOATTRIB, 0);
 
-		sm_sendprop_info_t spi;
-		if (!gamehelpers->FindSendPropInfo("CBaseCombatWeapon", "m_hOwnerEntity", &spi))
-			return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+// Map entities are spawned inside LevelInit, so this has to be a pre hook
+bool Hook_LevelInit(const char *pMapName, char const *pMapEntities, char const *pOldLevel, char const *pLandmarkName, bool loadGame, bool background)
+{
+	g_SpawnCapture.Close();
+	IOTrace_Reset();
+	g_PakCache.Clear();
+	g_bPakCache = g_pDetour_GetFileInfo && g_SvPakCache->GetBool();
+	Coalesce_Reset();
+	memset(g_UserInfoCache, 0, sizeof(g_UserInfoCache));
+	LoadKeyValueRules(pMapName);
+
+	// Factories may have come or gone with the map change
+	g_FactoryCache.Clear();
+
+	g_HudMessages.Reset();
+	g_CmdQueue.Clear();
+	g_TeleportBatch.Reset();
+	g_nViewControlChecks = 0;
+	g_nViewControlSent = 0;
+
+	// The old map's game_ui are gone
+	g_ParkedGameUIs.Clear();
+	g_nGameUIParked = 0;
+	g_nGameUIWoken = 0;
+
+	// Map entities are created before the first frame
+	UpdateEdictPressure();
+	g_EdictPressure.m_nAllowed = 0;
+	g_EdictPressure.m_nServerOnly = 0;
+	g_EdictPressure.m_nRefused = 0;
+
+	if (g_SvSpawnCapture->GetInt())
+	{
+		char path[PLATFORM_MAX_PATH];
+		g_pSM->BuildPath(Path_SM, path, sizeof(path), "data/cssfixes_spawns_%s.cskv", pMapName);
 
-		offset = spi.actual_offset;
+		if (g_SpawnCapture.Open(path, pMapName))
+			g_pSM->LogMessage(myself, "Capturing entity spawns to %s", path);
+		else
+			g_pSM->LogError(myself, "Could not open %s for spawn capture", path);
 	}
 
-	CBaseHandle &hndl = *(CBaseHandle *)((uint8_t *)this + offset);
+	RETURN_META_VALUE(MRES_IGNORED, true);
+}
 
-	edict_t *pEdict = gamehelpers->GetHandleEntity(hndl);
-	if(!pEdict)
-		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+void Hook_LevelShutdown()
+{
+	g_SpawnCapture.Close();
+	g_FactoryCache.Clear();
 
-	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(pEdict);
-	if(!pPlayer || !pPlayer->GetEdict())
-		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+	if(g_CmdQueue.m_nQueued)
+	{
+		AsyncLog("Command queue: %llu commands queued, %llu duplicates dropped, up to %u pending",
+			(unsigned long long)g_CmdQueue.m_nQueued, (unsigned long long)g_CmdQueue.m_nDeduplicated, (unsigned)g_CmdQueue.m_nMaxDepth);
+	}
 
-	IPlayerInfo *pInfo = pPlayer->GetPlayerInfo();
-	if(!pInfo)
-		return DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
+	// Commands of the old map's entities
+	g_CmdQueue.Clear();
 
-	g_FireBulletPlayerTeam = pInfo->GetTeamIndex();
+	if(g_TeleportBatch.m_nBatched || g_TeleportBatch.m_nDeduplicated)
+	{
+		// AsyncLog takes three arguments at most
+		AsyncLog("Teleport batching: %llu teleports, %llu batched (up to %d to one spot)",
+			(unsigned long long)g_TeleportBatch.m_nTeleports, (unsigned long long)g_TeleportBatch.m_nBatched, g_TeleportBatch.m_nLargestBatch);
+		AsyncLog("Teleport batching: %llu spread, %llu duplicates dropped",
+			(unsigned long long)g_TeleportBatch.m_nSpread, (unsigned long long)g_TeleportBatch.m_nDeduplicated);
+	}
 
-	g_InFireBullets = true;
-	bool bRet = DETOUR_MEMBER_CALL(DETOUR_SwingOrStab)(bStab);
-	g_InFireBullets = false;
+	if(g_EdictPressure.m_nServerOnly || g_EdictPressure.m_nRefused)
+	{
+		AsyncLog("Edict pressure: %llu spawns without an edict, %llu refused, %llu on budget",
+			(unsigned long long)g_EdictPressure.m_nServerOnly, (unsigned long long)g_EdictPressure.m_nRefused, (unsigned long long)g_EdictPressure.m_nAllowed);
+	}
 
-	return bRet;
+	g_bPakCache = false;
+	g_PakCache.Clear();
+
+	RETURN_META(MRES_IGNORED);
 }
 
-cell_t PhysboxToClientMap(IPluginContext *pContext, const cell_t *params)
+/* Detours only an optional feature needs: without one the feature is unavailable
+ * and its convar is forced off, instead of failing the load with all the fixes */
+bool UTIL_OptionalDetour(CDetour *pDetour, const char *pszName, ConVar *pFeature)
 {
-	if(params[2])
-		pContext->LocalToPhysAddr(params[1], (cell_t **)&g_pPhysboxToClientMap);
-	else
-		g_pPhysboxToClientMap = NULL;
+	if(pDetour)
+		return true;
 
-	return 0;
+	g_pSM->LogError(myself, "Could not create detour for %s, %s is unavailable", pszName, pFeature->GetName());
+	pFeature->SetValue(0);
+	return false;
 }
 
 bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
@@ -576,12 +2003,30 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 
 	g_iMaxPlayers = playerhelpers->GetMaxClients();
 
+	char log_path[PLATFORM_MAX_PATH];
+	g_pSM->BuildPath(Path_SM, log_path, sizeof(log_path), "logs/cssfixes.log");
+	AsyncLog_Start(log_path, SMEXT_CONF_LOGTAG);
+
+	memset(g_UseCache, 0, sizeof(g_UseCache));
+	memset(g_PassThroughMatrix, 0, sizeof(g_PassThroughMatrix));
+	memset(g_UserInfoCache, 0, sizeof(g_UserInfoCache));
+	HookProfile_Init();
+	playerhelpers->AddClientListener(this);
+
 	char conf_error[255] = "";
 	if(!gameconfs->LoadGameConfigFile("CSSFixes.games", &g_pGameConf, conf_error, sizeof(conf_error)))
 	{
 		if(conf_error[0])
 			snprintf(error, maxlength, "Could not read CSSFixes.games.txt: %s", conf_error);
 
+		// Stops the log thread and the client listener started above
+		SDK_OnUnload();
+		return false;
+	}
+
+	if(!Offsets_Resolve(g_pGameConf, error, maxlength))
+	{
+		SDK_OnUnload();
 		return false;
 	}
 
@@ -659,6 +2104,108 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 		return false;
 	}
 
+	g_pDetour_AcceptInput = DETOUR_CREATE_MEMBER(DETOUR_AcceptInput, "CBaseEntity_AcceptInput");
+	UTIL_OptionalDetour(g_pDetour_AcceptInput, "CBaseEntity_AcceptInput", g_SvIOTrace);
+
+	// The I/O trace keeps working without it, chains just restart at every delayed output
+	g_pDetour_AddEvent = DETOUR_CREATE_MEMBER(DETOUR_AddEvent, "CEventQueue_AddEvent");
+	UTIL_OptionalDetour(g_pDetour_AddEvent, "CEventQueue_AddEvent", g_SvCoalesceEvents);
+
+	g_pDetour_NET_GetLong = DETOUR_CREATE_STATIC(DETOUR_NET_GetLong, "NET_GetLong");
+	UTIL_OptionalDetour(g_pDetour_NET_GetLong, "NET_GetLong", g_SvNetLimit);
+
+	g_pDetour_FillUserInfo = DETOUR_CREATE_MEMBER(DETOUR_FillUserInfo, "CBaseClient_FillUserInfo");
+	UTIL_OptionalDetour(g_pDetour_FillUserInfo, "CBaseClient_FillUserInfo", g_SvUserInfoInterval);
+
+	// The filesystem lives in dedicated_srv.so, which gamedata can't look up symbols in.
+	// Linux only, like the rest of the gamedata.
+	void *pGetFileInfo = NULL;
+#ifndef _WIN32
+	void *pDedicated = dlopen("bin/dedicated_srv.so", RTLD_NOW);
+	if(pDedicated)
+	{
+		pGetFileInfo = memutils->ResolveSymbol(pDedicated, "_ZN12CZipPackFile11GetFileInfoEPKcRiRxS2_S2_Rt");
+		dlclose(pDedicated);
+	}
+#endif
+
+	if(pGetFileInfo)
+		g_pDetour_GetFileInfo = CDetourManager::CreateDetour(GET_MEMBER_CALLBACK(DETOUR_GetFileInfo), GET_MEMBER_TRAMPOLINE(DETOUR_GetFileInfo), pGetFileInfo);
+
+	UTIL_OptionalDetour(g_pDetour_GetFileInfo, "CZipPackFile::GetFileInfo", g_SvPakCache);
+
+	g_pDetour_UTIL_HudMessage = DETOUR_CREATE_STATIC(DETOUR_UTIL_HudMessage, "UTIL_HudMessage");
+	UTIL_OptionalDetour(g_pDetour_UTIL_HudMessage, "UTIL_HudMessage", g_SvHudMsgCoalesce);
+
+	// Both or neither, sv_cssfixes_cmdqueue keeps server and client commands in one order
+	g_pDetour_ServerCommandInput = DETOUR_CREATE_MEMBER(DETOUR_ServerCommandInput, "CPointServerCommand_InputCommand");
+	g_pDetour_ClientCommandInput = DETOUR_CREATE_MEMBER(DETOUR_ClientCommandInput, "CPointClientCommand_InputCommand");
+	if(!UTIL_OptionalDetour(g_pDetour_ServerCommandInput, "CPointServerCommand_InputCommand", g_SvCmdQueue) ||
+		!UTIL_OptionalDetour(g_pDetour_ClientCommandInput, "CPointClientCommand_InputCommand", g_SvCmdQueue))
+	{
+		if(g_pDetour_ServerCommandInput)
+		{
+			g_pDetour_ServerCommandInput->Destroy();
+			g_pDetour_ServerCommandInput = NULL;
+		}
+
+		if(g_pDetour_ClientCommandInput)
+		{
+			g_pDetour_ClientCommandInput->Destroy();
+			g_pDetour_ClientCommandInput = NULL;
+		}
+	}
+
+	g_pDetour_PointTeleportInput = DETOUR_CREATE_MEMBER(DETOUR_PointTeleportInput, "CPointTeleport_InputTeleport");
+	UTIL_OptionalDetour(g_pDetour_PointTeleportInput, "CPointTeleport_InputTeleport", g_SvTeleportBatch);
+
+	// A camera switched to a full check without the ShouldTransmit side would reach nobody
+	g_pDetour_ViewControlUpdateTransmitState = DETOUR_CREATE_MEMBER(DETOUR_ViewControlUpdateTransmitState, "CTriggerCamera_UpdateTransmitState");
+	g_pDetour_ShouldTransmit = DETOUR_CREATE_MEMBER(DETOUR_ShouldTransmit, "CBaseEntity_ShouldTransmit");
+	if(!UTIL_OptionalDetour(g_pDetour_ViewControlUpdateTransmitState, "CTriggerCamera_UpdateTransmitState", g_SvViewControlTransmit) ||
+		!UTIL_OptionalDetour(g_pDetour_ShouldTransmit, "CBaseEntity_ShouldTransmit", g_SvViewControlTransmit))
+	{
+		if(g_pDetour_ViewControlUpdateTransmitState)
+		{
+			g_pDetour_ViewControlUpdateTransmitState->Destroy();
+			g_pDetour_ViewControlUpdateTransmitState = NULL;
+		}
+
+		if(g_pDetour_ShouldTransmit)
+		{
+			g_pDetour_ShouldTransmit->Destroy();
+			g_pDetour_ShouldTransmit = NULL;
+		}
+	}
+
+	// sv_cssfixes_gameui_events needs all three, a parked game_ui nobody wakes up would be stuck
+	if(!g_pGameConf->GetMemSig("CBaseEntity_SetNextThink", (void **)(&g_pSetNextThink)) || !g_pSetNextThink)
+	{
+		g_pSetNextThink = NULL;
+		g_pSM->LogError(myself, "Failed to find CBaseEntity_SetNextThink, %s is unavailable", g_SvGameUIEvents->GetName());
+		g_SvGameUIEvents->SetValue(0);
+	}
+	else
+	{
+		g_pDetour_GameUIThink = DETOUR_CREATE_MEMBER(DETOUR_GameUIThink, "CGameUI_Think");
+		g_pDetour_PlayerRunCommand = DETOUR_CREATE_MEMBER(DETOUR_PlayerRunCommand, "CBasePlayer_PlayerRunCommand");
+		if(!UTIL_OptionalDetour(g_pDetour_GameUIThink, "CGameUI_Think", g_SvGameUIEvents) ||
+			!UTIL_OptionalDetour(g_pDetour_PlayerRunCommand, "CBasePlayer_PlayerRunCommand", g_SvGameUIEvents))
+		{
+			if(g_pDetour_GameUIThink)
+			{
+				g_pDetour_GameUIThink->Destroy();
+				g_pDetour_GameUIThink = NULL;
+			}
+
+			if(g_pDetour_PlayerRunCommand)
+			{
+				g_pDetour_PlayerRunCommand->Destroy();
+				g_pDetour_PlayerRunCommand = NULL;
+			}
+		}
+	}
+
 	g_pDetour_InputTestActivator->EnableDetour();
 	g_pDetour_PostConstructor->EnableDetour();
 	g_pDetour_CreateEntityByName->EnableDetour();
@@ -668,6 +2215,45 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 	g_pDetour_KeyValue->EnableDetour();
 	g_pDetour_FireBullets->EnableDetour();
 	g_pDetour_SwingOrStab->EnableDetour();
+	if(g_pDetour_AcceptInput)
+		g_pDetour_AcceptInput->EnableDetour();
+	if(g_pDetour_AddEvent)
+		g_pDetour_AddEvent->EnableDetour();
+	if(g_pDetour_NET_GetLong)
+		g_pDetour_NET_GetLong->EnableDetour();
+	if(g_pDetour_FillUserInfo)
+		g_pDetour_FillUserInfo->EnableDetour();
+	if(g_pDetour_GetFileInfo)
+		g_pDetour_GetFileInfo->EnableDetour();
+	if(g_pDetour_UTIL_HudMessage)
+		g_pDetour_UTIL_HudMessage->EnableDetour();
+	if(g_pDetour_ServerCommandInput)
+	{
+		g_pDetour_ServerCommandInput->EnableDetour();
+		g_pDetour_ClientCommandInput->EnableDetour();
+	}
+	if(g_pDetour_PointTeleportInput)
+		g_pDetour_PointTeleportInput->EnableDetour();
+	if(g_pDetour_ViewControlUpdateTransmitState)
+	{
+		g_pDetour_ViewControlUpdateTransmitState->EnableDetour();
+		g_pDetour_ShouldTransmit->EnableDetour();
+	}
+	if(g_pDetour_GameUIThink)
+	{
+		g_pDetour_GameUIThink->EnableDetour();
+		g_pDetour_PlayerRunCommand->EnableDetour();
+	}
+
+	typedef IEntityFactoryDictionary *(*EntityFactoryDictionary_t)();
+	EntityFactoryDictionary_t pEntityFactoryDictionary;
+	if(!g_pGameConf->GetMemSig("EntityFactoryDictionary", (void **)(&pEntityFactoryDictionary)) || !pEntityFactoryDictionary)
+	{
+		snprintf(error, maxlength, "Failed to find EntityFactoryDictionary.\n");
+		SDK_OnUnload();
+		return false;
+	}
+	g_pEntityFactoryDictionary = pEntityFactoryDictionary();
 
 	// Find VTable for CTraceFilterSkipTwoEntities
 	uintptr_t pCTraceFilterSkipTwoEntities;
@@ -757,7 +2343,8 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 			(unsigned char *)"\x90\x90\x90",
 			"bin/engine_srv.so"
 		},
-		// 10: fix server lagging resulting from too many ConMsgs due to packet spam
+		// 10: fix server lagging resulting from too many ConMsgs due to packet spam,
+		//     count them per source address instead (netmsg.h)
 		{
 			"_ZN8CNetChan19ProcessPacketHeaderEP11netpacket_s",
 			(unsigned char *)"_Z6ConMsgPKcz",
@@ -765,9 +2352,11 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 			(unsigned char *)"\x90\x90\x90\x90\x90",
 			"bin/engine_srv.so",
 			0x7d1, 100,
-			true, "bin/libtier0_srv.so"
+			true, "bin/libtier0_srv.so",
+			(void *)NetMsg_Redirect
 		},
-		// 11: fix server lagging resulting from too many ConMsgs due to packet spam
+		// 11: fix server lagging resulting from too many ConMsgs due to packet spam,
+		//     count them per source address instead (netmsg.h)
 		{
 			"_Z11NET_GetLongiP11netpacket_s",
 			(unsigned char *)"Msg",
@@ -775,7 +2364,8 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 			(unsigned char *)"\x90\x90\x90\x90\x90",
 			"bin/engine_srv.so",
 			0x800, 100,
-			true, "bin/libtier0_srv.so"
+			true, "bin/libtier0_srv.so",
+			(void *)NetMsg_Redirect
 		},
 		// 13: CTriggerCamera::FollowTarget: Don't early return when the player handle is null
 		{
@@ -825,7 +2415,7 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 
 		if (g_SvLogs->GetInt())
 		{
-			g_pSM->LogMessage(myself, "Forcing CT spawn");
+			AsyncLog("Forcing CT spawn");
 		}
 	}
 
@@ -964,15 +2554,27 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 			pRestore->pPatchAddress = pPatchAddress;
 			pRestore->pOriginal = (unsigned char *)malloc(PatchLen * sizeof(unsigned char));
 
+			const unsigned char *pPatchBytes = pPatch->pPatch;
+			unsigned char aRedirect[5];
+			if(pPatch->pRedirect)
+			{
+				// call rel32
+				int32_t rel = (int32_t)((uintptr_t)pPatch->pRedirect - (pPatchAddress + 5));
+				aRedirect[0] = 0xE8;
+				memcpy(&aRedirect[1], &rel, sizeof(rel));
+				pPatchBytes = aRedirect;
+			}
+
 			SourceHook::SetMemAccess((void *)pPatchAddress, PatchLen, SH_MEM_READ|SH_MEM_WRITE|SH_MEM_EXEC);
 			for(int j = 0; j < PatchLen; j++)
 			{
 				pRestore->pOriginal[j] = *(unsigned char *)(pPatchAddress + j);
-				*(unsigned char *)(pPatchAddress + j) = pPatch->pPatch[j];
+				*(unsigned char *)(pPatchAddress + j) = pPatchBytes[j];
 			}
 			SourceHook::SetMemAccess((void *)pPatchAddress, PatchLen, SH_MEM_READ|SH_MEM_EXEC);
 
 			ppRestore = &((*ppRestore)->pNext);
+			g_nPatchesApplied++;
 		}
 	}
 
@@ -982,12 +2584,24 @@ bool CSSFixes::SDK_OnLoad(char *error, size_t maxlength, bool late)
 		return false;
 	}
 
+	g_pSM->AddGameFrameHook(OnGameFrame);
+	SH_ADD_HOOK(IServerGameDLL, LevelInit, gamedll, SH_STATIC(Hook_LevelInit), false);
+	SH_ADD_HOOK(IServerGameDLL, LevelShutdown, gamedll, SH_STATIC(Hook_LevelShutdown), false);
+	SH_ADD_HOOK(IServerGameDLL, GameFrame, gamedll, SH_STATIC(Hook_GameFramePost), true);
+	gameevents->AddListener(&g_RoundStartListener, "round_start", true);
+
 	return true;
 }
 
 const sp_nativeinfo_t MyNatives[] =
 {
 	{ "PhysboxToClientMap", PhysboxToClientMap },
+	{ "SetPassThrough", SetPassThrough },
+	{ "GetPassThrough", GetPassThrough },
+	{ "ClearPassThrough", ClearPassThrough },
+	{ "GetHookProfile", GetHookProfile },
+	{ "ResetHookProfile", ResetHookProfile },
+	{ "SetViewControlDebug", SetViewControlDebug },
 	{ NULL, NULL }
 };
 
@@ -997,6 +2611,29 @@ void CSSFixes::SDK_OnAllLoaded()
 	sharesys->RegisterLibrary(myself, "CSSFixes");
 }
 
+void CSSFixes::OnClientConnected(int client)
+{
+	IGamePlayer *pPlayer = playerhelpers->GetGamePlayer(client);
+	g_ClientAddress[client] = pPlayer && !pPlayer->IsFakeClient() ? NetMsg_ParseAddress(pPlayer->GetIPAddress()) : 0;
+}
+
+void CSSFixes::OnClientPutInServer(int client)
+{
+	memset(&g_UseCache[client], 0, sizeof(g_UseCache[client]));
+	g_HudMessages.ResetSlot(client);
+}
+
+void CSSFixes::OnClientDisconnected(int client)
+{
+	memset(&g_UseCache[client], 0, sizeof(g_UseCache[client]));
+	memset(&g_UserInfoCache[client], 0, sizeof(g_UserInfoCache[client]));
+	g_HudMessages.ResetSlot(client);
+	ResetPassThrough(client);
+	g_bViewControlDebug[client] = false;
+	g_ParkedGameUIs.Clear(client);
+	g_ClientAddress[client] = 0;
+}
+
 bool CSSFixes::RegisterConCommandBase(ConCommandBase *pVar)
 {
 	/* Always call META_REGCVAR instead of going through the engine. */
@@ -1005,6 +2642,17 @@ bool CSSFixes::RegisterConCommandBase(ConCommandBase *pVar)
 
 void CSSFixes::SDK_OnUnload()
 {
+	g_pSM->RemoveGameFrameHook(OnGameFrame);
+	SH_REMOVE_HOOK(IServerGameDLL, LevelInit, gamedll, SH_STATIC(Hook_LevelInit), false);
+	SH_REMOVE_HOOK(IServerGameDLL, LevelShutdown, gamedll, SH_STATIC(Hook_LevelShutdown), false);
+	SH_REMOVE_HOOK(IServerGameDLL, GameFrame, gamedll, SH_STATIC(Hook_GameFramePost), true);
+	g_SpawnCapture.Close();
+	StatsPage_Close();
+	g_pStatsPage = NULL;
+	AsyncLog_Stop();
+	playerhelpers->RemoveClientListener(this);
+	gameevents->RemoveListener(&g_RoundStartListener);
+
 	if(g_pDetour_InputTestActivator != NULL)
 	{
 		g_pDetour_InputTestActivator->Destroy();
@@ -1059,13 +2707,108 @@ void CSSFixes::SDK_OnUnload()
 		g_pDetour_SwingOrStab = NULL;
 	}
 
+	if(g_pDetour_AcceptInput != NULL)
+	{
+		g_pDetour_AcceptInput->Destroy();
+		g_pDetour_AcceptInput = NULL;
+	}
+
+	if(g_pDetour_AddEvent != NULL)
+	{
+		g_pDetour_AddEvent->Destroy();
+		g_pDetour_AddEvent = NULL;
+	}
+
+	if(g_pDetour_NET_GetLong != NULL)
+	{
+		g_pDetour_NET_GetLong->Destroy();
+		g_pDetour_NET_GetLong = NULL;
+	}
+
+	if(g_pDetour_FillUserInfo != NULL)
+	{
+		g_pDetour_FillUserInfo->Destroy();
+		g_pDetour_FillUserInfo = NULL;
+	}
+
+	if(g_pDetour_GetFileInfo != NULL)
+	{
+		g_pDetour_GetFileInfo->Destroy();
+		g_pDetour_GetFileInfo = NULL;
+	}
+	g_bPakCache = false;
+
+	if(g_pDetour_UTIL_HudMessage != NULL)
+	{
+		g_pDetour_UTIL_HudMessage->Destroy();
+		g_pDetour_UTIL_HudMessage = NULL;
+	}
+	g_bHudMsgCoalesce = false;
+
+	if(g_pDetour_ServerCommandInput != NULL)
+	{
+		g_pDetour_ServerCommandInput->Destroy();
+		g_pDetour_ServerCommandInput = NULL;
+	}
+
+	if(g_pDetour_ClientCommandInput != NULL)
+	{
+		g_pDetour_ClientCommandInput->Destroy();
+		g_pDetour_ClientCommandInput = NULL;
+	}
+	g_bCmdQueue = false;
+	g_CmdQueue.Clear();
+
+	if(g_pDetour_PointTeleportInput != NULL)
+	{
+		g_pDetour_PointTeleportInput->Destroy();
+		g_pDetour_PointTeleportInput = NULL;
+	}
+	g_bTeleportBatch = false;
+
+	if(g_pDetour_ViewControlUpdateTransmitState != NULL)
+	{
+		g_pDetour_ViewControlUpdateTransmitState->Destroy();
+		g_pDetour_ViewControlUpdateTransmitState = NULL;
+	}
+
+	if(g_pDetour_ShouldTransmit != NULL)
+	{
+		g_pDetour_ShouldTransmit->Destroy();
+		g_pDetour_ShouldTransmit = NULL;
+	}
+	g_bViewControlTransmit = false;
+	g_pViewControlVTable = NULL;
+
+	// Before the detours go, parked game_ui would never think again
+	if(g_pSetNextThink)
+		WakeParkedGameUIs();
+	g_ParkedGameUIs.Clear();
+	g_bGameUIEvents = false;
+
+	if(g_pDetour_GameUIThink != NULL)
+	{
+		g_pDetour_GameUIThink->Destroy();
+		g_pDetour_GameUIThink = NULL;
+	}
+
+	if(g_pDetour_PlayerRunCommand != NULL)
+	{
+		g_pDetour_PlayerRunCommand->Destroy();
+		g_pDetour_PlayerRunCommand = NULL;
+	}
+
 	if(g_SH_SkipTwoEntitiesShouldHitEntity)
 		SH_REMOVE_HOOK_ID(g_SH_SkipTwoEntitiesShouldHitEntity);
 
 	if(g_SH_SimpleShouldHitEntity)
 		SH_REMOVE_HOOK_ID(g_SH_SimpleShouldHitEntity);
 
-	gameconfs->CloseGameConfigFile(g_pGameConf);
+	if(g_pGameConf)
+	{
+		gameconfs->CloseGameConfigFile(g_pGameConf);
+		g_pGameConf = NULL;
+	}
 
 	// Revert all applied patches
 	for(size_t i = 0; i < gs_Patches.size(); i++)
@@ -1099,50 +2842,10 @@ void CSSFixes::SDK_OnUnload()
 bool CSSFixes::SDK_OnMetamodLoad(ISmmAPI *ismm, char *error, size_t maxlen, bool late)
 {
 	GET_V_IFACE_CURRENT(GetEngineFactory, g_pCVar, ICvar, CVAR_INTERFACE_VERSION);
+	GET_V_IFACE_CURRENT(GetEngineFactory, gameevents, IGameEventManager2, INTERFACEVERSION_GAMEEVENTSMANAGER2);
+	GET_V_IFACE_CURRENT(GetEngineFactory, netstringtables, INetworkStringTableContainer, INTERFACENAME_NETWORKSTRINGTABLESERVER);
+	GET_V_IFACE_CURRENT(GetEngineFactory, enginetrace, IEngineTrace, INTERFACEVERSION_ENGINETRACE_SERVER);
+	gpGlobals = ismm->GetCGlobals();
 	ConVar_Register(0, this);
 	return true;
 }
-
-uintptr_t FindPattern(uintptr_t BaseAddr, const unsigned char *pData, const char *pPattern, size_t MaxSize)
-{
-	unsigned char *pMemory;
-	uintptr_t PatternLen = strlen(pPattern);
-
-	pMemory = reinterpret_cast<unsigned char *>(BaseAddr);
-
-	for(uintptr_t i = 0; i < MaxSize; i++)
-	{
-		uintptr_t Matches = 0;
-		while(*(pMemory + i + Matches) == pData[Matches] || pPattern[Matches] != 'x')
-		{
-			Matches++;
-			if(Matches == PatternLen)
-				return (uintptr_t)(pMemory + i);
-		}
-	}
-
-	return 0x00;
-}
-
-uintptr_t FindFunctionCall(uintptr_t BaseAddr, uintptr_t Function, size_t MaxSize)
-{
-	unsigned char *pMemory;
-	pMemory = reinterpret_cast<unsigned char *>(BaseAddr);
-
-	for(uintptr_t i = 0; i < MaxSize; i++)
-	{
-		if(pMemory[i] == 0xE8) // CALL
-		{
-			uintptr_t CallAddr = *(uintptr_t *)(pMemory + i + 1);
-
-			CallAddr += (uintptr_t)(pMemory + i + 5);
-
-			if(CallAddr == Function)
-				return (uintptr_t)(pMemory + i);
-
-			i += 4;
-		}
-	}
-
-	return 0x00;
-}
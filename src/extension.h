@@ -48,7 +48,7 @@ ret name(p1type p1name, p2type p2name, p3type p3name, p4type p4name, p5type p5na
  * @brief Sample implementation of the SDK Extension.
  * Note: Uncomment one of the pre-defined virtual functions in order to use it.
  */
-class CSSFixes : public SDKExtension, public IConCommandBaseAccessor
+class CSSFixes : public SDKExtension, public IConCommandBaseAccessor, public IClientListener
 {
 public:
 	/**
@@ -121,6 +121,11 @@ public:
 
 public:  // IConCommandBaseAccessor
 	virtual bool RegisterConCommandBase(ConCommandBase *pVar);
+
+public:  // IClientListener
+	virtual void OnClientConnected(int client);
+	virtual void OnClientPutInServer(int client);
+	virtual void OnClientDisconnected(int client);
 };
 
 #endif // _INCLUDE_SOURCEMOD_EXTENSION_PROPER_H_
@@ -0,0 +1,142 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "factorycache.h"
+#include <algorithm>
+#include <string.h>
+#include <strings.h>
+
+static const char *s_pszRemaps[][2] =
+{
+	// Nice of valve to expose CBaseFilter as filter_base :)
+	{ "filter_activator_context", "filter_base" },
+};
+
+const char *UTIL_RemapClassname(const char *pszClassname)
+{
+	for(size_t i = 0; i < sizeof(s_pszRemaps) / sizeof(*s_pszRemaps); i++)
+	{
+		if(strcasecmp(pszClassname, s_pszRemaps[i][0]) == 0)
+			return s_pszRemaps[i][1];
+	}
+
+	return NULL;
+}
+
+CFactoryCache::CFactoryCache() : m_nHits(0), m_nMisses(0)
+{
+}
+
+uint32_t CFactoryCache::Hash(const char *psz)
+{
+	// FNV-1a over the lowercased string
+	uint32_t nHash = 2166136261u;
+	for(; *psz; psz++)
+	{
+		unsigned char c = (unsigned char)*psz;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+
+		nHash = (nHash ^ c) * 16777619u;
+	}
+
+	return nHash;
+}
+
+FactoryCacheEntry *CFactoryCache::Find(const char *pszClassname)
+{
+	std::unordered_map<uint32_t, std::vector<FactoryCacheEntry *> >::const_iterator it = m_Index.find(Hash(pszClassname));
+	if(it != m_Index.end())
+	{
+		for(size_t i = 0; i < it->second.size(); i++)
+		{
+			if(strcasecmp(it->second[i]->sClassname.c_str(), pszClassname) == 0)
+			{
+				m_nHits++;
+				return it->second[i];
+			}
+		}
+	}
+
+	m_nMisses++;
+	return NULL;
+}
+
+FactoryCacheEntry *CFactoryCache::Add(const char *pszClassname, const char *pszCreateName, void *pFactory)
+{
+	m_Entries.push_back(FactoryCacheEntry());
+
+	FactoryCacheEntry *pEntry = &m_Entries.back();
+	pEntry->sClassname = pszClassname;
+	pEntry->pszCreateName = pszCreateName;
+	pEntry->pFactory = pFactory;
+	pEntry->nCreated = 0;
+
+	m_Index[Hash(pszClassname)].push_back(pEntry);
+	return pEntry;
+}
+
+void CFactoryCache::Clear()
+{
+	m_Index.clear();
+	m_Entries.clear();
+	m_nHits = 0;
+	m_nMisses = 0;
+}
+
+void CFactoryCache::ResetCounts()
+{
+	for(size_t i = 0; i < m_Entries.size(); i++)
+		m_Entries[i].nCreated = 0;
+
+	m_nHits = 0;
+	m_nMisses = 0;
+}
+
+int CFactoryCache::Top(const FactoryCacheEntry **ppEntries, int nMax) const
+{
+	std::vector<const FactoryCacheEntry *> sorted;
+	for(size_t i = 0; i < m_Entries.size(); i++)
+	{
+		if(m_Entries[i].nCreated)
+			sorted.push_back(&m_Entries[i]);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const FactoryCacheEntry *a, const FactoryCacheEntry *b) {
+		return a->nCreated > b->nCreated;
+	});
+
+	int nCount = std::min((int)sorted.size(), nMax);
+	for(int i = 0; i < nCount; i++)
+		ppEntries[i] = sorted[i];
+
+	return nCount;
+}
@@ -0,0 +1,95 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_FACTORYCACHE_H_
+#define _INCLUDE_CSSFIXES_FACTORYCACHE_H_
+
+/**
+ * @file factorycache.h
+ * @brief Classname to entity factory cache for DETOUR_CreateEntityByName.
+ *
+ * Every classname asked for is looked up once: the CSSFixes remap
+ * (filter_activator_context -> filter_base, ...) is applied and the factory
+ * for the result is taken from the engine's factory dictionary. Later
+ * creations of the same classname, in any case, hash straight to that
+ * entry. Entries also count how often their class was created.
+ *
+ * Other extensions and plugins can install, replace and remove factories
+ * at runtime, so the cache is cleared at every level change and classes
+ * without a factory aren't remembered. Factories changed in the middle of
+ * a map aren't seen until the next one.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct FactoryCacheEntry
+{
+	std::string sClassname;		// as first requested
+	const char *pszCreateName;	// remapped classname, NULL if it isn't remapped
+	void *pFactory;				// IEntityFactory
+	uint64_t nCreated;
+};
+
+class CFactoryCache
+{
+public:
+	CFactoryCache();
+
+	FactoryCacheEntry *Find(const char *pszClassname);
+	FactoryCacheEntry *Add(const char *pszClassname, const char *pszCreateName, void *pFactory);
+	void Clear();
+	void ResetCounts();
+
+	// Most created classes first, returns the number written to ppEntries
+	int Top(const FactoryCacheEntry **ppEntries, int nMax) const;
+	size_t Count() const { return m_Entries.size(); }
+
+public:
+	uint64_t m_nHits;
+	uint64_t m_nMisses;
+
+private:
+	static uint32_t Hash(const char *psz);
+
+private:
+	std::deque<FactoryCacheEntry> m_Entries;	// stable addresses
+	std::unordered_map<uint32_t, std::vector<FactoryCacheEntry *> > m_Index;
+};
+
+// Classes CSSFixes implements on top of another one, NULL if pszClassname isn't one of them
+const char *UTIL_RemapClassname(const char *pszClassname);
+
+#endif // _INCLUDE_CSSFIXES_FACTORYCACHE_H_
@@ -0,0 +1,139 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "flightrecorder.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+struct RecordedFrame
+{
+	FlightRecFrame frame;
+	FlightRecHook hooks[HookProfile_Count];
+};
+
+static RecordedFrame s_Frames[FLIGHTREC_MAX_FRAMES];
+static uint64_t s_nRecorded = 0;		// total frames recorded, s_Frames[s_nRecorded % FLIGHTREC_MAX_FRAMES] is next
+static uint64_t s_nSpike = 0;			// frame number of the spike being dumped
+static int s_nPending = -1;				// frames left to record before the dump, -1 = no spike
+static int s_nWindow = 0;
+static float s_flThresholdMs = 0.0f;
+
+bool FlightRecorder_RecordFrame(int iTick, float flFrameMs, float flThresholdMs, int nWindow)
+{
+	if(nWindow < 1)
+		nWindow = 1;
+	else if(nWindow > FLIGHTREC_MAX_FRAMES)
+		nWindow = FLIGHTREC_MAX_FRAMES;
+
+	RecordedFrame *pFrame = &s_Frames[s_nRecorded % FLIGHTREC_MAX_FRAMES];
+	pFrame->frame.iTick = iTick;
+	pFrame->frame.flFrameMs = flFrameMs;
+
+	double flMicrosecondsPerCycle = HookProfile_MicrosecondsPerCycle();
+	for(int i = 0; i < HookProfile_Count; i++)
+	{
+		pFrame->hooks[i].flMicroseconds = (float)(g_HookFrameCycles[i] * flMicrosecondsPerCycle);
+		pFrame->hooks[i].nCalls = g_HookFrameCalls[i];
+	}
+	HookProfile_ResetFrame();
+
+	uint64_t nFrame = s_nRecorded++;
+
+	if(s_nPending < 0 && flThresholdMs > 0.0f && flFrameMs > flThresholdMs)
+	{
+		s_nSpike = nFrame;
+		s_nPending = nWindow / 2;
+		s_nWindow = nWindow;
+		s_flThresholdMs = flThresholdMs;
+	}
+	else if(s_nPending > 0)
+	{
+		s_nPending--;
+	}
+
+	return s_nPending == 0;
+}
+
+bool FlightRecorder_Dump(const char *pszPath, const char *pszMap)
+{
+	if(s_nPending != 0)
+		return false;
+
+	s_nPending = -1;
+
+	uint64_t nFrames = s_nWindow;
+	if(nFrames > s_nRecorded)
+		nFrames = s_nRecorded;
+	uint64_t nFirst = s_nRecorded - nFrames;
+
+	FILE *pFile = fopen(pszPath, "wb");
+	if(!pFile)
+		return false;
+
+	FlightRecHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.szMagic, FLIGHTREC_MAGIC, sizeof(header.szMagic));
+	header.nVersion = FLIGHTREC_VERSION;
+	header.nHooks = HookProfile_Count;
+	header.nFrames = (uint32_t)nFrames;
+	header.nSpikeFrame = (uint32_t)(s_nSpike - nFirst);
+	header.flThresholdMs = s_flThresholdMs;
+	header.nTime = (int64_t)time(NULL);
+	strncpy(header.szMap, pszMap, sizeof(header.szMap) - 1);
+	fwrite(&header, sizeof(header), 1, pFile);
+
+	for(int i = 0; i < HookProfile_Count; i++)
+	{
+		char szName[FLIGHTREC_NAME_LENGTH];
+		memset(szName, 0, sizeof(szName));
+		strncpy(szName, g_pszHookProfileNames[i], sizeof(szName) - 1);
+		fwrite(szName, sizeof(szName), 1, pFile);
+	}
+
+	for(uint64_t i = nFirst; i < s_nRecorded; i++)
+	{
+		RecordedFrame *pFrame = &s_Frames[i % FLIGHTREC_MAX_FRAMES];
+		fwrite(&pFrame->frame, sizeof(pFrame->frame), 1, pFile);
+		fwrite(pFrame->hooks, sizeof(pFrame->hooks), 1, pFile);
+	}
+
+	bool bSuccess = !ferror(pFile);
+	fclose(pFile);
+	return bSuccess;
+}
+
+void FlightRecorder_Clear()
+{
+	s_nRecorded = 0;
+	s_nPending = -1;
+}
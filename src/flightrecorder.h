@@ -0,0 +1,90 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_FLIGHTRECORDER_H_
+#define _INCLUDE_CSSFIXES_FLIGHTRECORDER_H_
+
+/**
+ * @file flightrecorder.h
+ * @brief Per-frame ring buffer of server frame time and time spent in each hook,
+ * dumped to a binary file around frame time spikes.
+ *
+ * File layout (little endian, packed):
+ *   FlightRecHeader
+ *   nHooks hook names, FLIGHTREC_NAME_LENGTH bytes each, NUL padded
+ *   nFrames times: FlightRecFrame followed by nHooks FlightRecHook
+ */
+
+#include <stdint.h>
+
+#define FLIGHTREC_MAGIC			"CSFR"
+#define FLIGHTREC_VERSION		1
+#define FLIGHTREC_NAME_LENGTH	32
+#define FLIGHTREC_MAX_FRAMES	1024
+
+#pragma pack(push, 1)
+struct FlightRecHeader
+{
+	char szMagic[4];
+	uint32_t nVersion;
+	uint32_t nHooks;
+	uint32_t nFrames;
+	uint32_t nSpikeFrame;		// index of the frame that triggered the dump
+	float flThresholdMs;
+	int64_t nTime;				// unix time of the dump
+	char szMap[64];
+};
+
+struct FlightRecFrame
+{
+	int32_t iTick;
+	float flFrameMs;			// time since the previous server frame
+};
+
+struct FlightRecHook
+{
+	float flMicroseconds;		// inclusive time spent in the hook during the frame
+	uint32_t nCalls;
+};
+#pragma pack(pop)
+
+#ifndef FLIGHTREC_FORMAT_ONLY
+// Stores the frame that just ended and resets the per-frame hook counters.
+// Returns true once nWindow / 2 frames after a spike over flThresholdMs have been recorded.
+bool FlightRecorder_RecordFrame(int iTick, float flFrameMs, float flThresholdMs, int nWindow);
+
+// Writes the last nWindow frames around the pending spike to pszPath.
+bool FlightRecorder_Dump(const char *pszPath, const char *pszMap);
+
+void FlightRecorder_Clear();
+#endif
+
+#endif // _INCLUDE_CSSFIXES_FLIGHTRECORDER_H_
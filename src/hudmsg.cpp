@@ -0,0 +1,149 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "hudmsg.h"
+#include <string.h>
+
+CHudMessageQueue::CHudMessageQueue()
+{
+	Reset();
+}
+
+size_t CHudMessageQueue::MessageSize(const char *pszText)
+{
+	// channel, x, y, 2 colors, effect, fadein, fadeout, hold, fx time, text
+	return 1 + 4 + 4 + 4 + 4 + 1 + 4 + 4 + 4 + 4 + strlen(pszText) + 1;
+}
+
+bool CHudMessageQueue::Queue(int iSlot, const hudtextparms_t &params, const char *pszText, int nRecipients)
+{
+	int iChannel = params.channel;
+	if(iSlot < 0 || iSlot >= HUDMSG_SLOTS || iChannel < 0 || iChannel >= HUDMSG_CHANNELS)
+		return false;
+
+	size_t nLength = strlen(pszText);
+	if(nLength >= HUDMSG_TEXT_LENGTH)
+		return false;
+
+	m_nQueued++;
+
+	HudMessageSlot &slot = m_Slots[iSlot][iChannel];
+	if(slot.bPending)
+	{
+		m_nReplaced++;
+		m_nBytesSaved += MessageSize(slot.pending.szText) * nRecipients;
+	}
+	else
+		m_nPending++;
+
+	// Everyone's screen gets this one, earlier per player ones of the tick are moot
+	if(iSlot == 0)
+	{
+		for(int i = 1; i < HUDMSG_SLOTS; i++)
+		{
+			HudMessageSlot &player = m_Slots[i][iChannel];
+			if(!player.bPending)
+				continue;
+
+			player.bPending = false;
+			m_nPending--;
+			m_nReplaced++;
+			m_nBytesSaved += MessageSize(player.pending.szText);
+		}
+	}
+
+	slot.bPending = true;
+	slot.pending.params = params;
+	memcpy(slot.pending.szText, pszText, nLength + 1);
+	return true;
+}
+
+double CHudMessageQueue::Duration(const HudMessage &message)
+{
+	const hudtextparms_t &params = message.params;
+
+	// Effect 2 writes the text out one character per fade in time
+	double flDuration = params.fadeinTime + params.holdTime + params.fadeoutTime;
+	if(params.effect == 2)
+		flDuration += params.fadeinTime * strlen(message.szText) + params.fxTime;
+
+	return flDuration;
+}
+
+// A resend that would hold the text longer than the last one does, keeping it up, isn't suppressed
+bool CHudMessageQueue::IsOnScreen(const HudMessageSlot &slot, double flNow)
+{
+	return flNow + slot.pending.params.holdTime <= slot.flExpire &&
+		memcmp(&slot.pending.params, &slot.last.params, sizeof(hudtextparms_t)) == 0 &&
+		strcmp(slot.pending.szText, slot.last.szText) == 0;
+}
+
+void CHudMessageQueue::Sent(int iSlot, int iChannel, double flNow)
+{
+	HudMessageSlot &slot = m_Slots[iSlot][iChannel];
+
+	slot.last.params = slot.pending.params;
+	strcpy(slot.last.szText, slot.pending.szText);
+	slot.flExpire = flNow + Duration(slot.last);
+
+	// What's on screen now differs between the all players slot and the player slots
+	if(iSlot == 0)
+	{
+		for(int i = 1; i < HUDMSG_SLOTS; i++)
+			m_Slots[i][iChannel].flExpire = 0.0;
+	}
+	else
+		m_Slots[0][iChannel].flExpire = 0.0;
+}
+
+void CHudMessageQueue::ResetSlot(int iSlot)
+{
+	for(int iChannel = 0; iChannel < HUDMSG_CHANNELS; iChannel++)
+	{
+		HudMessageSlot &slot = m_Slots[iSlot][iChannel];
+		if(slot.bPending)
+			m_nPending--;
+
+		slot.bPending = false;
+		slot.flExpire = 0.0;
+		m_Slots[0][iChannel].flExpire = 0.0;
+	}
+}
+
+void CHudMessageQueue::Reset()
+{
+	memset(m_Slots, 0, sizeof(m_Slots));
+	m_nPending = 0;
+	m_nQueued = 0;
+	m_nReplaced = 0;
+	m_nSuppressed = 0;
+	m_nBytesSaved = 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_HUDMSG_H_
+#define _INCLUDE_CSSFIXES_HUDMSG_H_
+
+/**
+ * @file hudmsg.h
+ * @brief Per tick coalescing of UTIL_HudMessage (game_text) calls.
+ *
+ * Messages are kept per recipient and channel until the end of the tick,
+ * a later one for the same recipient and channel replaces the earlier one.
+ * Slot 0 holds messages for all players, queueing one drops the per player
+ * messages of that channel since it would overwrite them anyway. At flush
+ * the all players messages go out first.
+ *
+ * A message identical to the last one sent to the same slot and channel
+ * is suppressed while that one stays on screen for at least its hold time,
+ * so resending a text to keep it up still gets through.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HUDMSG_SLOTS		66		// 0 = all players, 1-65 = clients
+#define HUDMSG_CHANNELS		8
+#define HUDMSG_TEXT_LENGTH	512
+
+// Game side layout
+struct hudtextparms_t
+{
+	float x;
+	float y;
+	int effect;
+	unsigned char r1, g1, b1, a1;
+	unsigned char r2, g2, b2, a2;
+	float fadeinTime;
+	float fadeoutTime;
+	float holdTime;
+	float fxTime;
+	int channel;
+};
+
+struct HudMessage
+{
+	hudtextparms_t params;
+	char szText[HUDMSG_TEXT_LENGTH];
+};
+
+struct HudMessageSlot
+{
+	bool bPending;
+	HudMessage pending;
+	HudMessage last;	// last one sent
+	double flExpire;	// end of the fade out of the last one, 0 = not on screen
+};
+
+class CHudMessageQueue
+{
+public:
+	CHudMessageQueue();
+
+	// Returns false if the message can't be held back (channel out of range, text too long)
+	bool Queue(int iSlot, const hudtextparms_t &params, const char *pszText, int nRecipients);
+
+	/**
+	 * Send(int iSlot, const hudtextparms_t &params, const char *pszText)
+	 * is called for every pending message that isn't suppressed.
+	 * nAllRecipients is the number of players slot 0 messages reach.
+	 */
+	template <typename F>
+	void Flush(double flNow, int nAllRecipients, F Send)
+	{
+		if(!m_nPending)
+			return;
+
+		for(int iSlot = 0; iSlot < HUDMSG_SLOTS; iSlot++)
+		{
+			for(int iChannel = 0; iChannel < HUDMSG_CHANNELS; iChannel++)
+			{
+				HudMessageSlot &slot = m_Slots[iSlot][iChannel];
+				if(!slot.bPending)
+					continue;
+
+				slot.bPending = false;
+				if(IsOnScreen(slot, flNow))
+				{
+					m_nSuppressed++;
+					m_nBytesSaved += MessageSize(slot.pending.szText) * (iSlot ? 1 : nAllRecipients);
+					continue;
+				}
+
+				Sent(iSlot, iChannel, flNow);
+				Send(iSlot, slot.pending.params, slot.pending.szText);
+			}
+		}
+
+		m_nPending = 0;
+	}
+
+	// The client's screen is gone (connect/disconnect), all players messages no longer describe everyone's screen either
+	void ResetSlot(int iSlot);
+	void Reset();
+
+	// Bytes of a HudMsg user message with this text
+	static size_t MessageSize(const char *pszText);
+
+public:
+	uint64_t m_nQueued;
+	uint64_t m_nReplaced;		// dropped for a later message in the same tick
+	uint64_t m_nSuppressed;		// identical to what stays on screen long enough
+	uint64_t m_nBytesSaved;
+
+private:
+	static double Duration(const HudMessage &message);
+	static bool IsOnScreen(const HudMessageSlot &slot, double flNow);
+	void Sent(int iSlot, int iChannel, double flNow);
+
+private:
+	int m_nPending;
+	HudMessageSlot m_Slots[HUDMSG_SLOTS][HUDMSG_CHANNELS];
+};
+
+#endif // _INCLUDE_CSSFIXES_HUDMSG_H_
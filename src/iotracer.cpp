@@ -0,0 +1,297 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "iotracer.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+uint64_t g_nIOTraceInputs = 0;
+uint64_t g_nIOTraceOutputs = 0;
+uint32_t g_nIOTraceDropped = 0;
+uint32_t g_nIOTraceUncarried = 0;
+
+struct IOTraceFrame
+{
+	IOTraceEntry *pEntry;
+	uint64_t nStart;
+	uint64_t nChildCycles;
+};
+
+static IOTraceEntry s_Table[IOTRACE_TABLE_SIZE];
+static uint32_t s_nEntries = 0;
+static IOTraceFrame s_Stack[IOTRACE_MAX_DEPTH];
+static int s_nDepth = 0;
+// Nesting past IOTRACE_MAX_DEPTH isn't traced but still has to be unwound
+static int s_nUntracedDepth = 0;
+
+#define IOTRACE_PENDING_PROBES	16
+
+// The chain of a queued event, until the queue fires it
+struct IOTracePending
+{
+	bool bUsed;
+	IOTraceEvent event;
+	float flFireTime;
+	uint32_t nDepth;
+	char szOrigin[IOTRACE_NAME_LENGTH * 2];
+	char szActivator[IOTRACE_NAME_LENGTH];
+};
+
+static IOTracePending s_Pending[IOTRACE_PENDING_SIZE];
+
+// The running chain, set by its outermost input
+static char s_szChainOrigin[IOTRACE_NAME_LENGTH * 2];
+static char s_szChainActivator[IOTRACE_NAME_LENGTH];
+static uint32_t s_nChainDepth = 0;	// inputs before the event queue
+
+static inline uint32_t HashPair(const char *pszTarget, const char *pszInput)
+{
+	// FNV-1a over both strings
+	uint32_t nHash = 2166136261u;
+	for(const char *p = pszTarget; *p; p++)
+		nHash = (nHash ^ (unsigned char)*p) * 16777619u;
+	nHash = (nHash ^ '.') * 16777619u;
+	for(const char *p = pszInput; *p; p++)
+		nHash = (nHash ^ (unsigned char)*p) * 16777619u;
+	return nHash;
+}
+
+static inline void CopyName(char *pszDest, const char *pszSrc)
+{
+	strncpy(pszDest, pszSrc, IOTRACE_NAME_LENGTH - 1);
+	pszDest[IOTRACE_NAME_LENGTH - 1] = 0;
+}
+
+static inline uint32_t HashEvent(const IOTraceEvent &event)
+{
+	// FNV-1a over the pointers and the output id
+	const void *pKeys[3] = { event.pszInput, event.pActivator, event.pCaller };
+	uint32_t nHash = 2166136261u;
+	const unsigned char *p = (const unsigned char *)pKeys;
+	for(size_t i = 0; i < sizeof(pKeys); i++)
+		nHash = (nHash ^ p[i]) * 16777619u;
+	p = (const unsigned char *)&event.iOutputID;
+	for(size_t i = 0; i < sizeof(event.iOutputID); i++)
+		nHash = (nHash ^ p[i]) * 16777619u;
+	return nHash;
+}
+
+static inline bool SameEvent(const IOTraceEvent &a, const IOTraceEvent &b)
+{
+	return a.pszInput == b.pszInput && a.pActivator == b.pActivator && a.pCaller == b.pCaller && a.iOutputID == b.iOutputID;
+}
+
+// Entries aren't removed when their event fires, a target name can match several entities
+static const IOTracePending *FindPending(const IOTraceEvent &event, float flNow)
+{
+	uint32_t nHash = HashEvent(event);
+	for(uint32_t i = 0; i < IOTRACE_PENDING_PROBES; i++)
+	{
+		const IOTracePending *pPending = &s_Pending[(nHash + i) & (IOTRACE_PENDING_SIZE - 1)];
+		if(pPending->bUsed && SameEvent(pPending->event, event) &&
+			pPending->flFireTime <= flNow + 0.001f && flNow <= pPending->flFireTime + IOTRACE_PENDING_EXPIRE)
+			return pPending;
+	}
+
+	return NULL;
+}
+
+static IOTraceEntry *FindOrAdd(const char *pszTarget, const char *pszInput)
+{
+	uint32_t nHash = HashPair(pszTarget, pszInput);
+	for(uint32_t i = 0; i < IOTRACE_TABLE_SIZE; i++)
+	{
+		IOTraceEntry *pEntry = &s_Table[(nHash + i) & (IOTRACE_TABLE_SIZE - 1)];
+		if(!pEntry->nCalls)
+		{
+			// Keep a quarter of the table free so probes stay short
+			if(s_nEntries >= IOTRACE_TABLE_SIZE / 4 * 3)
+				return NULL;
+
+			s_nEntries++;
+			CopyName(pEntry->szTarget, pszTarget);
+			CopyName(pEntry->szInput, pszInput);
+			pEntry->nHash = nHash;
+			return pEntry;
+		}
+
+		if(pEntry->nHash == nHash &&
+			strncmp(pEntry->szTarget, pszTarget, IOTRACE_NAME_LENGTH - 1) == 0 &&
+			strncmp(pEntry->szInput, pszInput, IOTRACE_NAME_LENGTH - 1) == 0)
+			return pEntry;
+	}
+
+	return NULL;
+}
+
+void IOTrace_Reset()
+{
+	memset(s_Table, 0, sizeof(s_Table));
+	memset(s_Pending, 0, sizeof(s_Pending));
+	s_nEntries = 0;
+	g_nIOTraceInputs = 0;
+	g_nIOTraceOutputs = 0;
+	g_nIOTraceDropped = 0;
+	g_nIOTraceUncarried = 0;
+	// The stack is left alone, a reset can happen from inside an input
+}
+
+bool IOTrace_Enter(const char *pszTarget, const char *pszActivator, const IOTraceEvent &event, float flNow)
+{
+	const char *pszInput = event.pszInput;
+	g_nIOTraceInputs++;
+
+	IOTraceEntry *pEntry = NULL;
+	if(s_nDepth < IOTRACE_MAX_DEPTH && !s_nUntracedDepth)
+		pEntry = FindOrAdd(pszTarget, pszInput);
+
+	if(!pEntry)
+	{
+		g_nIOTraceDropped++;
+		s_nUntracedDepth++;
+		return false;
+	}
+
+	// Outermost input: continue the chain that queued it, or start one
+	if(!s_nDepth)
+	{
+		const IOTracePending *pPending = FindPending(event, flNow);
+		if(pPending)
+		{
+			memcpy(s_szChainOrigin, pPending->szOrigin, sizeof(s_szChainOrigin));
+			memcpy(s_szChainActivator, pPending->szActivator, sizeof(s_szChainActivator));
+			s_nChainDepth = pPending->nDepth;
+		}
+		else
+		{
+			snprintf(s_szChainOrigin, sizeof(s_szChainOrigin), "%s.%s", pEntry->szTarget, pEntry->szInput);
+			CopyName(s_szChainActivator, pszActivator);
+			s_nChainDepth = 0;
+		}
+	}
+
+	pEntry->nCalls++;
+	if(s_nChainDepth + s_nDepth + 1 > pEntry->nMaxDepth)
+		pEntry->nMaxDepth = s_nChainDepth + s_nDepth + 1;
+
+	memcpy(pEntry->szOrigin, s_szChainOrigin, sizeof(pEntry->szOrigin));
+	memcpy(pEntry->szActivator, s_szChainActivator, sizeof(pEntry->szActivator));
+
+	IOTraceFrame *pFrame = &s_Stack[s_nDepth++];
+	pFrame->pEntry = pEntry;
+	pFrame->nChildCycles = 0;
+	pFrame->nStart = HookProfile_Timestamp();
+	return true;
+}
+
+void IOTrace_Leave()
+{
+	if(s_nUntracedDepth)
+	{
+		s_nUntracedDepth--;
+		return;
+	}
+
+	if(!s_nDepth)
+		return;
+
+	IOTraceFrame *pFrame = &s_Stack[--s_nDepth];
+	uint64_t nCycles = HookProfile_Timestamp() - pFrame->nStart;
+
+	// The table may have been reset while this input ran
+	IOTraceEntry *pEntry = pFrame->pEntry;
+	if(pEntry->nCalls)
+	{
+		pEntry->nCycles += nCycles;
+		pEntry->nSelfCycles += nCycles > pFrame->nChildCycles ? nCycles - pFrame->nChildCycles : 0;
+	}
+
+	if(s_nDepth)
+		s_Stack[s_nDepth - 1].nChildCycles += nCycles;
+}
+
+void IOTrace_Output(const IOTraceEvent &event, float flNow, float flFireTime)
+{
+	g_nIOTraceOutputs++;
+
+	// Queued outside of a traced input, the event starts its own chain
+	if(!s_nDepth || s_nUntracedDepth)
+		return;
+
+	s_Stack[s_nDepth - 1].pEntry->nFanOut++;
+
+	// Free slots and the ones of events long past their fire time are taken
+	uint32_t nHash = HashEvent(event);
+	for(uint32_t i = 0; i < IOTRACE_PENDING_PROBES; i++)
+	{
+		IOTracePending *pPending = &s_Pending[(nHash + i) & (IOTRACE_PENDING_SIZE - 1)];
+		if(pPending->bUsed && flNow <= pPending->flFireTime + IOTRACE_PENDING_EXPIRE)
+			continue;
+
+		pPending->bUsed = true;
+		pPending->event = event;
+		pPending->flFireTime = flFireTime;
+		pPending->nDepth = s_nChainDepth + s_nDepth;
+		memcpy(pPending->szOrigin, s_szChainOrigin, sizeof(pPending->szOrigin));
+		memcpy(pPending->szActivator, s_szChainActivator, sizeof(pPending->szActivator));
+		return;
+	}
+
+	g_nIOTraceUncarried++;
+}
+
+int IOTrace_Top(const IOTraceEntry **ppEntries, int nMax)
+{
+	int nCount = 0;
+	for(int i = 0; i < IOTRACE_TABLE_SIZE && nMax > 0; i++)
+	{
+		const IOTraceEntry *pEntry = &s_Table[i];
+		if(!pEntry->nCalls)
+			continue;
+
+		// Insertion into the sorted top list
+		int j;
+		if(nCount < nMax)
+			j = nCount++;
+		else if(ppEntries[nMax - 1]->nSelfCycles < pEntry->nSelfCycles)
+			j = nMax - 1;
+		else
+			continue;
+
+		for(; j > 0 && ppEntries[j - 1]->nSelfCycles < pEntry->nSelfCycles; j--)
+			ppEntries[j] = ppEntries[j - 1];
+
+		ppEntries[j] = pEntry;
+	}
+
+	return nCount;
+}
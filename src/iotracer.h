@@ -0,0 +1,101 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_IOTRACER_H_
+#define _INCLUDE_CSSFIXES_IOTRACER_H_
+
+/**
+ * @file iotracer.h
+ * @brief Cost of entity I/O per targetname/input pair.
+ *
+ * Every AcceptInput is a frame on a small stack, so the time spent in nested
+ * inputs is subtracted from the parent's self time and outputs queued while
+ * an input runs count towards its fan-out. The chain root (outermost input
+ * and its activator) is kept as the origin of each pair.
+ *
+ * Delayed outputs and everything added with AddEvent go through the event
+ * queue. Queueing one remembers the chain (origin, activator, depth) in a
+ * side table keyed by the event (input string, activator, caller, output
+ * id), the input the queue fires for it continues that chain one level
+ * deeper. Events queued while the side table is full, and the ones added
+ * with an entity instead of a target name (CEventQueue's other AddEvent),
+ * start a new chain. Classes that override CBaseEntity::AcceptInput aren't
+ * traced at all.
+ */
+
+#include <stdint.h>
+
+#define IOTRACE_NAME_LENGTH		48
+#define IOTRACE_TABLE_SIZE		4096	// power of two
+#define IOTRACE_MAX_DEPTH		64
+#define IOTRACE_PENDING_SIZE	2048	// power of two
+// A remembered event this many seconds past its fire time was serviced or cancelled
+#define IOTRACE_PENDING_EXPIRE	1.0f
+
+struct IOTraceEntry
+{
+	char szTarget[IOTRACE_NAME_LENGTH];
+	char szInput[IOTRACE_NAME_LENGTH];
+	char szOrigin[IOTRACE_NAME_LENGTH * 2];	// "<target>.<input>" of the chain root
+	char szActivator[IOTRACE_NAME_LENGTH];	// classname of the chain's activator
+	uint32_t nHash;
+	uint32_t nCalls;
+	uint32_t nFanOut;			// outputs queued while this input ran
+	uint32_t nMaxDepth;			// counting the inputs of the chain before the event queue
+	uint64_t nCycles;			// including nested inputs
+	uint64_t nSelfCycles;
+};
+
+// Counts all inputs, including the ones that didn't fit into the table
+extern uint64_t g_nIOTraceInputs;
+extern uint64_t g_nIOTraceOutputs;
+extern uint32_t g_nIOTraceDropped;
+extern uint32_t g_nIOTraceUncarried;	// queued events whose chain didn't fit into the side table
+
+// What the event queue hands to AcceptInput again, pszInput is the same pointer
+struct IOTraceEvent
+{
+	const char *pszInput;
+	const void *pActivator;
+	const void *pCaller;
+	int iOutputID;
+};
+
+void IOTrace_Reset();
+// Call around the original AcceptInput, returns false if it isn't traced
+bool IOTrace_Enter(const char *pszTarget, const char *pszActivator, const IOTraceEvent &event, float flNow);
+void IOTrace_Leave();
+// An output was queued to fire at flFireTime
+void IOTrace_Output(const IOTraceEvent &event, float flNow, float flFireTime);
+// Fills ppEntries with up to nMax pairs sorted by self time, returns the count
+int IOTrace_Top(const IOTraceEntry **ppEntries, int nMax);
+
+#endif // _INCLUDE_CSSFIXES_IOTRACER_H_
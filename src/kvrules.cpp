@@ -0,0 +1,217 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "kvrules.h"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+bool UTIL_PatternMatch(const char *pszPattern, const char *pszString)
+{
+	const char *pStar = NULL;
+	const char *pResume = NULL;
+
+	while(*pszString)
+	{
+		if(*pszPattern == '*')
+		{
+			pStar = pszPattern++;
+			pResume = pszString;
+		}
+		else if(*pszPattern == '?' || tolower((unsigned char)*pszPattern) == tolower((unsigned char)*pszString))
+		{
+			pszPattern++;
+			pszString++;
+		}
+		else if(pStar)
+		{
+			// Let the last '*' eat one more character
+			pszPattern = pStar + 1;
+			pszString = ++pResume;
+		}
+		else
+			return false;
+	}
+
+	while(*pszPattern == '*')
+		pszPattern++;
+
+	return !*pszPattern;
+}
+
+CKeyValueRules::CKeyValueRules() : m_nChecked(0), m_nApplied(0)
+{
+}
+
+void CKeyValueRules::Clear()
+{
+	m_Rules.clear();
+	m_Exact.clear();
+	m_AnyClass.clear();
+	m_Wildcard.clear();
+}
+
+void CKeyValueRules::Add(const KeyValueRule &rule)
+{
+	m_Rules.push_back(rule);
+}
+
+bool CKeyValueRules::HasWildcard(const std::string &s)
+{
+	return s.find_first_of("*?") != std::string::npos;
+}
+
+uint32_t CKeyValueRules::Hash(const char *psz, uint32_t nHash)
+{
+	// FNV-1a over the lowercased string
+	for(; *psz; psz++)
+	{
+		unsigned char c = (unsigned char)*psz;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+
+		nHash = (nHash ^ c) * 16777619u;
+	}
+
+	return nHash;
+}
+
+size_t CKeyValueRules::Compile(const char *pszMap)
+{
+	m_Exact.clear();
+	m_AnyClass.clear();
+	m_Wildcard.clear();
+	m_nChecked = 0;
+	m_nApplied = 0;
+
+	size_t nRules = 0;
+	for(size_t i = 0; i < m_Rules.size(); i++)
+	{
+		const KeyValueRule &rule = m_Rules[i];
+		if(!UTIL_PatternMatch(rule.sMap.c_str(), pszMap))
+			continue;
+
+		if(HasWildcard(rule.sKey))
+			m_Wildcard.push_back((int)i);
+		else if(HasWildcard(rule.sClassname))
+			m_AnyClass[Hash(rule.sKey.c_str(), 2166136261u)].push_back((int)i);
+		else
+			m_Exact[Hash(rule.sKey.c_str(), Hash(rule.sClassname.c_str(), 2166136261u) * 31)].push_back((int)i);
+
+		nRules++;
+	}
+
+	return nRules;
+}
+
+int CKeyValueRules::FindBucket(uint32_t nKey, const char *pszClassname, const char *pszKeyName, const char *pszValue, bool bAnyClass, int iBest)
+{
+	std::unordered_map<uint32_t, std::vector<int> > &map = bAnyClass ? m_AnyClass : m_Exact;
+	std::unordered_map<uint32_t, std::vector<int> >::const_iterator it = map.find(nKey);
+	if(it == map.end())
+		return iBest;
+
+	// Buckets are in file order, the first hit is the best one in this bucket
+	for(size_t i = 0; i < it->second.size(); i++)
+	{
+		int iRule = it->second[i];
+		if(iBest >= 0 && iRule >= iBest)
+			break;
+
+		// Hashes can collide, compare the real strings
+		const KeyValueRule &rule = m_Rules[iRule];
+		if(strcasecmp(rule.sKey.c_str(), pszKeyName) != 0)
+			continue;
+
+		if(bAnyClass ? !UTIL_PatternMatch(rule.sClassname.c_str(), pszClassname) : strcasecmp(rule.sClassname.c_str(), pszClassname) != 0)
+			continue;
+
+		if(UTIL_PatternMatch(rule.sValue.c_str(), pszValue))
+			return iRule;
+	}
+
+	return iBest;
+}
+
+KeyValueRuleAction CKeyValueRules::Apply(const char *pszClassname, const char **pszKeyName, const char **pszValue)
+{
+	if(m_Exact.empty() && m_AnyClass.empty() && m_Wildcard.empty())
+		return KeyValueRule_None;
+
+	m_nChecked++;
+
+	if(!pszClassname)
+		pszClassname = "";
+
+	int iBest = -1;
+	if(!m_Exact.empty())
+		iBest = FindBucket(Hash(*pszKeyName, Hash(pszClassname, 2166136261u) * 31), pszClassname, *pszKeyName, *pszValue, false, iBest);
+
+	if(!m_AnyClass.empty())
+		iBest = FindBucket(Hash(*pszKeyName, 2166136261u), pszClassname, *pszKeyName, *pszValue, true, iBest);
+
+	for(size_t i = 0; i < m_Wildcard.size(); i++)
+	{
+		int iRule = m_Wildcard[i];
+		if(iBest >= 0 && iRule >= iBest)
+			break;
+
+		const KeyValueRule &rule = m_Rules[iRule];
+		if(UTIL_PatternMatch(rule.sKey.c_str(), *pszKeyName) &&
+			UTIL_PatternMatch(rule.sClassname.c_str(), pszClassname) &&
+			UTIL_PatternMatch(rule.sValue.c_str(), *pszValue))
+		{
+			iBest = iRule;
+			break;
+		}
+	}
+
+	if(iBest < 0)
+		return KeyValueRule_None;
+
+	const KeyValueRule &rule = m_Rules[iBest];
+	switch(rule.action)
+	{
+	case KeyValueRule_Set:
+		*pszValue = rule.sTo.c_str();
+		break;
+
+	case KeyValueRule_Rename:
+		*pszKeyName = rule.sTo.c_str();
+		break;
+
+	default:
+		break;
+	}
+
+	m_nApplied++;
+	return rule.action;
+}
@@ -0,0 +1,108 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_KVRULES_H_
+#define _INCLUDE_CSSFIXES_KVRULES_H_
+
+/**
+ * @file kvrules.h
+ * @brief Keyvalue rewrite rules from configs/cssfixes_keyvalues.cfg.
+ *
+ * Every rule matches map, classname, key and value against case insensitive
+ * patterns ('*' and '?' wildcards) and sets the value, renames the key or
+ * drops the keyvalue. Compile() keeps the rules of the current map and files
+ * them by a case insensitive hash of (classname, key): rules with a literal
+ * key are found with one or two hash lookups, only rules with a wildcard key
+ * are scanned.
+ * If several rules match, the first one in the file wins.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum KeyValueRuleAction
+{
+	KeyValueRule_None = 0,
+	KeyValueRule_Set,		// replace the value with szTo
+	KeyValueRule_Rename,	// replace the key name with szTo
+	KeyValueRule_Drop,		// don't pass the keyvalue to the entity at all
+};
+
+struct KeyValueRule
+{
+	std::string sMap;
+	std::string sClassname;
+	std::string sKey;
+	std::string sValue;
+	KeyValueRuleAction action;
+	std::string sTo;
+};
+
+class CKeyValueRules
+{
+public:
+	CKeyValueRules();
+
+	// Configured rules, any map
+	void Clear();
+	void Add(const KeyValueRule &rule);
+	size_t Count() const { return m_Rules.size(); }
+
+	// Builds the matcher for pszMap, returns the number of rules that apply to it
+	size_t Compile(const char *pszMap);
+
+	// Applies the first matching rule to *pszKeyName/*pszValue, the new strings live until the next Compile()
+	KeyValueRuleAction Apply(const char *pszClassname, const char **pszKeyName, const char **pszValue);
+
+public:
+	uint64_t m_nChecked;
+	uint64_t m_nApplied;
+
+private:
+	static bool HasWildcard(const std::string &s);
+	static uint32_t Hash(const char *psz, uint32_t nHash);
+	int FindBucket(uint32_t nKey, const char *pszClassname, const char *pszKeyName, const char *pszValue, bool bAnyClass, int iBest);
+
+private:
+	std::vector<KeyValueRule> m_Rules;
+
+	// Compiled for the current map, indices into m_Rules in file order
+	std::unordered_map<uint32_t, std::vector<int> > m_Exact;		// hash of classname and key
+	std::unordered_map<uint32_t, std::vector<int> > m_AnyClass;		// hash of key, classname is a pattern
+	std::vector<int> m_Wildcard;									// key is a pattern
+};
+
+// Case insensitive match with '*' (any run) and '?' (any character)
+bool UTIL_PatternMatch(const char *pszPattern, const char *pszString);
+
+#endif // _INCLUDE_CSSFIXES_KVRULES_H_
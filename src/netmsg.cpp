@@ -0,0 +1,204 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "netmsg.h"
+#include <string.h>
+
+uint64_t g_nNetMsgTotal = 0;
+uint32_t g_nNetMsgInterval = 0;
+uint32_t g_nNetMsgSources = 0;
+uint32_t g_nNetMsgUnknown = 0;
+const char *g_pszNetMsgLast = NULL;
+
+static NetMsgSource s_Table[NETMSG_TABLE_SIZE];
+
+// Skips to the first %s argument, NULL if there is none
+static const char *FindStringArgument(const char *pszFormat, va_list args)
+{
+	for(const char *p = pszFormat; *p; p++)
+	{
+		if(*p != '%')
+			continue;
+
+		p++;
+		if(*p == '%')
+			continue;
+
+		// Flags, width, precision and length
+		int nLong = 0;
+		for(; *p && strchr("-+ #0123456789.*lhLqjzt", *p); p++)
+		{
+			if(*p == '*')
+				va_arg(args, int);
+			else if(*p == 'l')
+				nLong++;
+			else if(*p == 'L' || *p == 'q' || *p == 'j')
+				nLong = 2;
+		}
+
+		switch(*p)
+		{
+			case 's':
+				return va_arg(args, const char *);
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+				va_arg(args, double);
+				break;
+			case 'p':
+				va_arg(args, void *);
+				break;
+			case 0:
+				return NULL;
+			default:
+				if(nLong >= 2)
+					va_arg(args, long long);
+				else if(nLong)
+					va_arg(args, long);
+				else
+					va_arg(args, int);
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+uint32_t NetMsg_ParseAddress(const char *pszAddress)
+{
+	uint32_t nAddress = 0;
+	const char *p = pszAddress;
+	for(int i = 0; i < 4; i++)
+	{
+		if(*p < '0' || *p > '9')
+			return 0;
+
+		uint32_t nOctet = 0;
+		for(int j = 0; j < 3 && *p >= '0' && *p <= '9'; j++, p++)
+			nOctet = nOctet * 10 + (*p - '0');
+
+		if(nOctet > 255 || (i < 3 && *p++ != '.'))
+			return 0;
+
+		nAddress = (nAddress << 8) | nOctet;
+	}
+
+	if(*p && *p != ':')
+		return 0;
+
+	return nAddress;
+}
+
+void NetMsg_Count(const char *pszFormat, va_list args)
+{
+	g_nNetMsgTotal++;
+	g_nNetMsgInterval++;
+
+	uint32_t nAddress = 0;
+	const char *pszAddress = pszFormat ? FindStringArgument(pszFormat, args) : NULL;
+	if(pszAddress)
+		nAddress = NetMsg_ParseAddress(pszAddress);
+
+	if(!nAddress)
+	{
+		g_nNetMsgUnknown++;
+		return;
+	}
+
+	uint32_t nHash = nAddress * 2654435761u;
+	for(uint32_t i = 0; i < NETMSG_TABLE_SIZE; i++)
+	{
+		NetMsgSource *pSource = &s_Table[(nHash + i) & (NETMSG_TABLE_SIZE - 1)];
+		if(pSource->nAddress == nAddress)
+		{
+			pSource->nCount++;
+			pSource->pszLastFormat = pszFormat;
+			return;
+		}
+
+		if(!pSource->nAddress)
+		{
+			// Spoofed floods can fill the table, keep probes short
+			if(g_nNetMsgSources >= NETMSG_TABLE_SIZE / 4 * 3)
+				break;
+
+			g_nNetMsgSources++;
+			pSource->nAddress = nAddress;
+			pSource->nCount = 1;
+			pSource->pszLastFormat = pszFormat;
+			return;
+		}
+	}
+
+	g_nNetMsgUnknown++;
+}
+
+void NetMsg_Redirect(const char *pszFormat, ...)
+{
+	g_pszNetMsgLast = pszFormat;
+
+	va_list args;
+	va_start(args, pszFormat);
+	NetMsg_Count(pszFormat, args);
+	va_end(args);
+}
+
+int NetMsg_Top(const NetMsgSource **ppSources, int nMax)
+{
+	int nCount = 0;
+	for(int i = 0; i < NETMSG_TABLE_SIZE && nMax > 0; i++)
+	{
+		const NetMsgSource *pSource = &s_Table[i];
+		if(!pSource->nAddress)
+			continue;
+
+		int j;
+		if(nCount < nMax)
+			j = nCount++;
+		else if(ppSources[nMax - 1]->nCount < pSource->nCount)
+			j = nMax - 1;
+		else
+			continue;
+
+		for(; j > 0 && ppSources[j - 1]->nCount < pSource->nCount; j--)
+			ppSources[j] = ppSources[j - 1];
+
+		ppSources[j] = pSource;
+	}
+
+	return nCount;
+}
+
+void NetMsg_Reset()
+{
+	memset(s_Table, 0, sizeof(s_Table));
+	g_nNetMsgInterval = 0;
+	g_nNetMsgSources = 0;
+	g_nNetMsgUnknown = 0;
+}
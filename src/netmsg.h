@@ -0,0 +1,74 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_NETMSG_H_
+#define _INCLUDE_CSSFIXES_NETMSG_H_
+
+/**
+ * @file netmsg.h
+ * @brief Counts the packet header messages of CNetChan::ProcessPacketHeader
+ * and NET_GetLong per source address instead of printing them.
+ *
+ * Their ConMsg/Msg calls are patched into calls to NetMsg_Redirect, which
+ * takes the address from the first %s argument ("a.b.c.d:port").
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#define NETMSG_TABLE_SIZE		1024	// power of two
+
+struct NetMsgSource
+{
+	uint32_t nAddress;			// host order, 0 = free slot / unknown address
+	uint32_t nCount;
+	const char *pszLastFormat;	// engine string, stays valid
+};
+
+// Since load
+extern uint64_t g_nNetMsgTotal;
+// Since the last NetMsg_Reset
+extern uint32_t g_nNetMsgInterval;
+extern uint32_t g_nNetMsgSources;
+extern uint32_t g_nNetMsgUnknown;	// no address or the table was full
+// Format of the latest redirected message, callers clear it to see whether a check complained
+extern const char *g_pszNetMsgLast;
+
+// Replaces ConMsg/Msg, must stay cdecl variadic
+void NetMsg_Redirect(const char *pszFormat, ...);
+void NetMsg_Count(const char *pszFormat, va_list args);
+// "a.b.c.d[:port]" to a host order address, 0 if it isn't one
+uint32_t NetMsg_ParseAddress(const char *pszAddress);
+// Sources with the most messages since the last reset
+int NetMsg_Top(const NetMsgSource **ppSources, int nMax);
+void NetMsg_Reset();
+
+#endif // _INCLUDE_CSSFIXES_NETMSG_H_
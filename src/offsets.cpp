@@ -0,0 +1,123 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "offsets.h"
+
+CSSFixesOffsets g_Offsets;
+CDataTableMembership<SendTable> g_BaseCombatWeaponTables("DT_BaseCombatWeapon");
+
+static bool ResolveDataMap(datamap_t *pMap, const char *pszName, int *pOffset, char *error, size_t maxlength)
+{
+	sm_datatable_info_t info;
+	if(!gamehelpers->FindDataMapInfo(pMap, pszName, &info))
+	{
+		snprintf(error, maxlength, "Could not find datamap offset for %s::%s", pMap->dataClassName, pszName);
+		return false;
+	}
+
+	*pOffset = info.actual_offset;
+	return true;
+}
+
+static bool ResolveSendProp(const char *pszClass, const char *pszName, int *pOffset, char *error, size_t maxlength)
+{
+	sm_sendprop_info_t info;
+	if(!gamehelpers->FindSendPropInfo(pszClass, pszName, &info))
+	{
+		snprintf(error, maxlength, "Could not find sendprop offset for %s::%s", pszClass, pszName);
+		return false;
+	}
+
+	*pOffset = info.actual_offset;
+	return true;
+}
+
+bool Offsets_Resolve(IGameConfig *pGameConf, char *error, size_t maxlength)
+{
+	memset(&g_Offsets, 0, sizeof(g_Offsets));
+	g_BaseCombatWeaponTables.Reset();
+
+	// No entity exists yet during load, go through the static CBaseEntity datamap
+	datamap_t *pMap = NULL;
+	if(!pGameConf->GetMemSig("CBaseEntity_m_DataMap", (void **)&pMap) || !pMap)
+	{
+		snprintf(error, maxlength, "Failed to find CBaseEntity_m_DataMap.");
+		return false;
+	}
+
+	datamap_t *pTeleportMap = NULL;
+	if(!pGameConf->GetMemSig("CPointTeleport_m_DataMap", (void **)&pTeleportMap) || !pTeleportMap)
+	{
+		snprintf(error, maxlength, "Failed to find CPointTeleport_m_DataMap.");
+		return false;
+	}
+
+	datamap_t *pCameraMap = NULL;
+	if(!pGameConf->GetMemSig("CTriggerCamera_m_DataMap", (void **)&pCameraMap) || !pCameraMap)
+	{
+		snprintf(error, maxlength, "Failed to find CTriggerCamera_m_DataMap.");
+		return false;
+	}
+
+	datamap_t *pPlayerMap = NULL;
+	if(!pGameConf->GetMemSig("CBasePlayer_m_DataMap", (void **)&pPlayerMap) || !pPlayerMap)
+	{
+		snprintf(error, maxlength, "Failed to find CBasePlayer_m_DataMap.");
+		return false;
+	}
+
+	datamap_t *pGameUIMap = NULL;
+	if(!pGameConf->GetMemSig("CGameUI_m_DataMap", (void **)&pGameUIMap) || !pGameUIMap)
+	{
+		snprintf(error, maxlength, "Failed to find CGameUI_m_DataMap.");
+		return false;
+	}
+
+	return ResolveDataMap(pMap, "m_iEFlags", &g_Offsets.m_iEFlags, error, maxlength) &&
+		ResolveDataMap(pMap, "m_iName", &g_Offsets.m_iName, error, maxlength) &&
+		ResolveDataMap(pMap, "m_ResponseContexts", &g_Offsets.m_ResponseContexts, error, maxlength) &&
+		ResolveDataMap(pMap, "m_iszResponseContext", &g_Offsets.m_iszResponseContext, error, maxlength) &&
+		ResolveDataMap(pMap, "m_vecAbsVelocity", &g_Offsets.m_vecAbsVelocity, error, maxlength) &&
+		ResolveDataMap(pMap, "m_vecViewOffset", &g_Offsets.m_vecViewOffset, error, maxlength) &&
+		ResolveDataMap(pMap, "m_target", &g_Offsets.m_target, error, maxlength) &&
+		ResolveDataMap(pTeleportMap, "m_vSaveOrigin", &g_Offsets.m_vSaveOrigin, error, maxlength) &&
+		ResolveDataMap(pTeleportMap, "m_vSaveAngles", &g_Offsets.m_vSaveAngles, error, maxlength) &&
+		ResolveDataMap(pCameraMap, "m_hPlayer", &g_Offsets.m_hPlayer, error, maxlength) &&
+		ResolveDataMap(pCameraMap, "m_state", &g_Offsets.m_state, error, maxlength) &&
+		ResolveDataMap(pPlayerMap, "m_hViewEntity", &g_Offsets.m_hViewEntity, error, maxlength) &&
+		ResolveDataMap(pPlayerMap, "m_nButtons", &g_Offsets.m_nButtons, error, maxlength) &&
+		ResolveDataMap(pGameUIMap, "m_player", &g_Offsets.m_player, error, maxlength) &&
+		ResolveDataMap(pGameUIMap, "m_nLastButtonState", &g_Offsets.m_nLastButtonState, error, maxlength) &&
+		ResolveDataMap(pGameUIMap, "m_bForceUpdate", &g_Offsets.m_bForceUpdate, error, maxlength) &&
+		ResolveDataMap(pGameUIMap, "m_flFieldOfView", &g_Offsets.m_flFieldOfView, error, maxlength) &&
+		ResolveSendProp("CBasePlayer", "m_lifeState", &g_Offsets.m_lifeState, error, maxlength) &&
+		ResolveSendProp("CBaseCombatWeapon", "m_hOwnerEntity", &g_Offsets.m_hOwnerEntity, error, maxlength);
+}
@@ -0,0 +1,87 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_OFFSETS_H_
+#define _INCLUDE_CSSFIXES_OFFSETS_H_
+
+/**
+ * @file offsets.h
+ * @brief Datamap and sendprop offsets used by the detours.
+ *
+ * Everything is resolved once in SDK_OnLoad, a missing offset fails the load
+ * instead of a hook quietly misbehaving halfway through a map.
+ */
+
+#include "extension.h"
+#include "utils.h"
+
+struct CSSFixesOffsets
+{
+	// CBaseEntity datamap
+	int m_iEFlags;
+	int m_iName;
+	int m_ResponseContexts;
+	int m_iszResponseContext;
+	int m_vecAbsVelocity;
+	int m_vecViewOffset;
+	int m_target;
+
+	// CPointTeleport datamap
+	int m_vSaveOrigin;
+	int m_vSaveAngles;
+
+	// CTriggerCamera datamap
+	int m_hPlayer;
+	int m_state;
+
+	// CBasePlayer datamap
+	int m_hViewEntity;
+	int m_nButtons;
+
+	// CGameUI datamap
+	int m_player;
+	int m_nLastButtonState;
+	int m_bForceUpdate;
+	int m_flFieldOfView;
+
+	// Sendprops
+	int m_lifeState;		// CBasePlayer
+	int m_hOwnerEntity;		// CBaseCombatWeapon
+};
+
+extern CSSFixesOffsets g_Offsets;
+
+// Per ServerClass "is a DT_BaseCombatWeapon" cache for DETOUR_SwingOrStab
+extern CDataTableMembership<SendTable> g_BaseCombatWeaponTables;
+
+bool Offsets_Resolve(IGameConfig *pGameConf, char *error, size_t maxlength);
+
+#endif // _INCLUDE_CSSFIXES_OFFSETS_H_
@@ -0,0 +1,134 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "pakcache.h"
+#include <string.h>
+
+// Lowercase with forward slashes, the way entries store their name
+static inline unsigned char NormalizeChar(unsigned char c)
+{
+	if(c == '\\')
+		return '/';
+
+	if(c >= 'A' && c <= 'Z')
+		return c + ('a' - 'A');
+
+	return c;
+}
+
+CPakFileInfoCache::CPakFileInfoCache() : m_nHits(0), m_nMisses(0)
+{
+}
+
+uint32_t CPakFileInfoCache::Hash(const void *pPackFile, const char *pszFilename)
+{
+	// FNV-1a over the pack file pointer and the normalized name
+	uint32_t nHash = 2166136261u;
+	const unsigned char *pPointer = (const unsigned char *)&pPackFile;
+	for(size_t i = 0; i < sizeof(pPackFile); i++)
+		nHash = (nHash ^ pPointer[i]) * 16777619u;
+
+	for(const char *p = pszFilename; *p; p++)
+		nHash = (nHash ^ NormalizeChar((unsigned char)*p)) * 16777619u;
+
+	return nHash;
+}
+
+bool CPakFileInfoCache::Matches(const PakFileEntry &entry, const void *pPackFile, const char *pszFilename)
+{
+	if(entry.pPackFile != pPackFile)
+		return false;
+
+	const char *pszStored = entry.sFilename.c_str();
+	for(; *pszFilename; pszFilename++, pszStored++)
+	{
+		if(NormalizeChar((unsigned char)*pszFilename) != (unsigned char)*pszStored)
+			return false;
+	}
+
+	return *pszStored == 0;
+}
+
+PakFileEntry *CPakFileInfoCache::Find(uint32_t nHash, const void *pPackFile, const char *pszFilename)
+{
+	std::unordered_map<uint32_t, std::vector<PakFileEntry> >::iterator it = m_Files.find(nHash);
+	if(it == m_Files.end())
+		return NULL;
+
+	for(size_t i = 0; i < it->second.size(); i++)
+	{
+		if(Matches(it->second[i], pPackFile, pszFilename))
+			return &it->second[i];
+	}
+
+	return NULL;
+}
+
+bool CPakFileInfoCache::Lookup(const void *pPackFile, const char *pszFilename, PakFileInfo *pInfo)
+{
+	PakFileEntry *pEntry = Find(Hash(pPackFile, pszFilename), pPackFile, pszFilename);
+	if(!pEntry)
+	{
+		m_nMisses++;
+		return false;
+	}
+
+	m_nHits++;
+	*pInfo = pEntry->info;
+	return true;
+}
+
+void CPakFileInfoCache::Store(const void *pPackFile, const char *pszFilename, const PakFileInfo &info)
+{
+	uint32_t nHash = Hash(pPackFile, pszFilename);
+	PakFileEntry *pEntry = Find(nHash, pPackFile, pszFilename);
+	if(pEntry)
+	{
+		pEntry->info = info;
+		return;
+	}
+
+	PakFileEntry entry;
+	entry.pPackFile = pPackFile;
+	entry.sFilename.reserve(strlen(pszFilename));
+	for(const char *p = pszFilename; *p; p++)
+		entry.sFilename.push_back((char)NormalizeChar((unsigned char)*p));
+	entry.info = info;
+
+	m_Files[nHash].push_back(entry);
+}
+
+void CPakFileInfoCache::Clear()
+{
+	m_Files.clear();
+	m_nHits = 0;
+	m_nMisses = 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_PAKCACHE_H_
+#define _INCLUDE_CSSFIXES_PAKCACHE_H_
+
+/**
+ * @file pakcache.h
+ * @brief Case insensitive memo of CZipPackFile::GetFileInfo results.
+ *
+ * The pack file directory is private to the filesystem, so the index is
+ * built from the lookups themselves: the first lookup of a name goes to the
+ * engine, every later one in any case and with either slash comes from here.
+ * Misses are remembered as well. Lookups hash the name as it is passed in,
+ * only storing a new one allocates.
+ *
+ * Not thread safe, lookups from other threads than the main one (the async
+ * loader) have to go to the engine.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PakFileInfo
+{
+	bool bFound;
+	int nBaseIndex;
+	int64_t nFileOffset;
+	int nOriginalSize;
+	int nCompressedSize;
+	unsigned short nCompressionMethod;
+};
+
+struct PakFileEntry
+{
+	const void *pPackFile;		// names are only unique per pack file
+	std::string sFilename;		// lowercased, forward slashes
+	PakFileInfo info;
+};
+
+class CPakFileInfoCache
+{
+public:
+	CPakFileInfoCache();
+
+	bool Lookup(const void *pPackFile, const char *pszFilename, PakFileInfo *pInfo);
+	void Store(const void *pPackFile, const char *pszFilename, const PakFileInfo &info);
+	void Clear();
+
+public:
+	uint64_t m_nHits;
+	uint64_t m_nMisses;
+
+private:
+	static uint32_t Hash(const void *pPackFile, const char *pszFilename);
+	static bool Matches(const PakFileEntry &entry, const void *pPackFile, const char *pszFilename);
+	PakFileEntry *Find(uint32_t nHash, const void *pPackFile, const char *pszFilename);
+
+private:
+	std::unordered_map<uint32_t, std::vector<PakFileEntry> > m_Files;
+};
+
+#endif // _INCLUDE_CSSFIXES_PAKCACHE_H_
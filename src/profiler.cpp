@@ -0,0 +1,168 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "profiler.h"
+#include <string.h>
+#include <tier0/platform.h>
+
+bool g_bHookProfiling = false;
+bool g_bHookStats = false;
+HookProfileStats g_HookProfileStats[HookProfile_Count];
+uint64_t g_HookFrameCycles[HookProfile_Count];
+uint32_t g_HookFrameCalls[HookProfile_Count];
+
+const char *g_pszHookProfileNames[HookProfile_Count] =
+{
+	"InputTestActivator",
+	"PostConstructor",
+	"CreateEntityByName",
+	"PassesFilterImpl",
+	"KeyValue",
+	"FindUseEntity",
+	"CTraceFilterSimple",
+	"ShouldHitEntity",
+	"FireBullets",
+	"SwingOrStab",
+	"AcceptInput",
+	"AddEvent",
+	"NET_GetLong",
+	"FillUserInfo",
+	"GetFileInfo",
+	"UTIL_HudMessage",
+	"ServerCommandInput",
+	"ClientCommandInput",
+	"PointTeleportInput",
+	"UpdateTransmitState",
+	"ShouldTransmit",
+	"GameUIThink",
+	"PlayerRunCommand",
+};
+
+// TSC frequency is measured between load and the time stats are read
+static uint64_t s_nCalibrationCycles = 0;
+static double s_flCalibrationTime = 0.0;
+
+static inline int CyclesToBucket(uint64_t nCycles)
+{
+	if(nCycles < 4)
+		return (int)nCycles;
+
+	int log2 = 63 - __builtin_clzll(nCycles);
+	int fraction = (int)((nCycles >> (log2 - 2)) & 3);
+	return log2 * 4 + fraction;
+}
+
+static inline uint64_t BucketToCycles(int bucket)
+{
+	if(bucket < 4)
+		return bucket;
+
+	int log2 = bucket / 4;
+	uint64_t fraction = bucket % 4;
+	// Upper bound of the bucket
+	return ((4 + fraction + 1) << (log2 - 2)) - 1;
+}
+
+void HookProfile_Init()
+{
+	s_nCalibrationCycles = HookProfile_Timestamp();
+	s_flCalibrationTime = Plat_FloatTime();
+	HookProfile_Reset();
+	HookProfile_ResetFrame();
+}
+
+void HookProfile_Reset()
+{
+	memset(g_HookProfileStats, 0, sizeof(g_HookProfileStats));
+	for(int i = 0; i < HookProfile_Count; i++)
+		g_HookProfileStats[i].nMinCycles = UINT64_MAX;
+}
+
+void HookProfile_ResetFrame()
+{
+	memset(g_HookFrameCycles, 0, sizeof(g_HookFrameCycles));
+	memset(g_HookFrameCalls, 0, sizeof(g_HookFrameCalls));
+}
+
+void HookProfile_Record(HookProfile id, uint64_t nCycles)
+{
+	g_HookFrameCycles[id] += nCycles;
+	g_HookFrameCalls[id]++;
+
+	if(!g_bHookStats)
+		return;
+
+	HookProfileStats *pStats = &g_HookProfileStats[id];
+
+	pStats->nCalls++;
+	pStats->nTotalCycles += nCycles;
+	if(nCycles < pStats->nMinCycles)
+		pStats->nMinCycles = nCycles;
+	if(nCycles > pStats->nMaxCycles)
+		pStats->nMaxCycles = nCycles;
+	pStats->nBuckets[CyclesToBucket(nCycles)]++;
+}
+
+double HookProfile_MicrosecondsPerCycle()
+{
+	double flElapsed = Plat_FloatTime() - s_flCalibrationTime;
+	uint64_t nElapsedCycles = HookProfile_Timestamp() - s_nCalibrationCycles;
+	if(flElapsed <= 0.0 || !nElapsedCycles)
+		return 0.0;
+
+	return (flElapsed * 1000000.0) / (double)nElapsedCycles;
+}
+
+double HookProfile_CyclesToMicroseconds(double flCycles)
+{
+	return flCycles * HookProfile_MicrosecondsPerCycle();
+}
+
+uint64_t HookProfile_Percentile(HookProfile id, double flPercentile)
+{
+	HookProfileStats *pStats = &g_HookProfileStats[id];
+	if(!pStats->nCalls)
+		return 0;
+
+	uint64_t nTarget = (uint64_t)(pStats->nCalls * flPercentile);
+	uint64_t nSeen = 0;
+	for(int i = 0; i < HOOKPROFILE_BUCKETS; i++)
+	{
+		nSeen += pStats->nBuckets[i];
+		if(nSeen > nTarget)
+		{
+			uint64_t nCycles = BucketToCycles(i);
+			return nCycles > pStats->nMaxCycles ? pStats->nMaxCycles : nCycles;
+		}
+	}
+
+	return pStats->nMaxCycles;
+}
@@ -0,0 +1,132 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_PROFILER_H_
+#define _INCLUDE_CSSFIXES_PROFILER_H_
+
+/**
+ * @file profiler.h
+ * @brief Low overhead cycle counters for the extension's detours and hooks.
+ */
+
+#include <stdint.h>
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// Keep in sync with CSSFixesHook in CSSFixes.inc
+enum HookProfile
+{
+	HookProfile_InputTestActivator = 0,
+	HookProfile_PostConstructor,
+	HookProfile_CreateEntityByName,
+	HookProfile_PassesFilterImpl,
+	HookProfile_KeyValue,
+	HookProfile_FindUseEntity,
+	HookProfile_CTraceFilterSimple,
+	HookProfile_ShouldHitEntity,
+	HookProfile_FireBullets,
+	HookProfile_SwingOrStab,
+	HookProfile_AcceptInput,
+	HookProfile_AddEvent,
+	HookProfile_NET_GetLong,
+	HookProfile_FillUserInfo,
+	HookProfile_GetFileInfo,
+	HookProfile_UTIL_HudMessage,
+	HookProfile_ServerCommandInput,
+	HookProfile_ClientCommandInput,
+	HookProfile_PointTeleportInput,
+	HookProfile_UpdateTransmitState,
+	HookProfile_ShouldTransmit,
+	HookProfile_GameUIThink,
+	HookProfile_PlayerRunCommand,
+
+	HookProfile_Count
+};
+
+// 4 buckets per power of two, enough for a p99 within ~20%
+#define HOOKPROFILE_BUCKETS (64 * 4)
+
+struct HookProfileStats
+{
+	uint64_t nCalls;
+	uint64_t nTotalCycles;
+	uint64_t nMinCycles;
+	uint64_t nMaxCycles;
+	uint32_t nBuckets[HOOKPROFILE_BUCKETS];
+};
+
+// Scopes only take timestamps while something consumes them
+extern bool g_bHookProfiling;
+// Aggregate into g_HookProfileStats (sv_cssfixes_profile)
+extern bool g_bHookStats;
+extern HookProfileStats g_HookProfileStats[HookProfile_Count];
+// Time spent in each hook since the last HookProfile_ResetFrame, for the flight recorder
+extern uint64_t g_HookFrameCycles[HookProfile_Count];
+extern uint32_t g_HookFrameCalls[HookProfile_Count];
+extern const char *g_pszHookProfileNames[HookProfile_Count];
+
+void HookProfile_Init();
+void HookProfile_Reset();
+void HookProfile_ResetFrame();
+void HookProfile_Record(HookProfile id, uint64_t nCycles);
+double HookProfile_MicrosecondsPerCycle();
+double HookProfile_CyclesToMicroseconds(double flCycles);
+uint64_t HookProfile_Percentile(HookProfile id, double flPercentile);
+
+static inline uint64_t HookProfile_Timestamp()
+{
+	return __rdtsc();
+}
+
+class CHookProfileScope
+{
+public:
+	inline CHookProfileScope(HookProfile id) : m_Id(id), m_nStart(g_bHookProfiling ? HookProfile_Timestamp() : 0)
+	{
+	}
+
+	inline ~CHookProfileScope()
+	{
+		if(m_nStart)
+			HookProfile_Record(m_Id, HookProfile_Timestamp() - m_nStart);
+	}
+
+private:
+	HookProfile m_Id;
+	uint64_t m_nStart;
+};
+
+#define HOOK_PROFILE_SCOPE(id) CHookProfileScope __hookProfileScope(id)
+
+#endif // _INCLUDE_CSSFIXES_PROFILER_H_
@@ -0,0 +1,164 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "ratelimit.h"
+#include <stddef.h>
+
+#define RATELIMIT_TOKEN		1000
+
+CRateLimiter::CRateLimiter() : m_nBlocked(0), m_nPenalties(0), m_nUntracked(0), m_nBurst(0), m_nRefill(0)
+{
+	Configure(20.0f, 2.0f);
+	Reset();
+}
+
+void CRateLimiter::Configure(float flBurst, float flRefill)
+{
+	if(flBurst < 1.0f)
+		flBurst = 1.0f;
+	if(flRefill < 0.0f)
+		flRefill = 0.0f;
+
+	m_nBurst = (int32_t)(flBurst * RATELIMIT_TOKEN);
+	m_nRefill = (int32_t)(flRefill * RATELIMIT_TOKEN);
+}
+
+void CRateLimiter::Reset()
+{
+	for(int i = 0; i < RATELIMIT_TABLE_SIZE; i++)
+	{
+		m_Buckets[i].nAddress.store(0, std::memory_order_relaxed);
+		m_Buckets[i].nState.store(0, std::memory_order_relaxed);
+	}
+
+	m_nBlocked = 0;
+	m_nPenalties = 0;
+	m_nUntracked = 0;
+}
+
+int32_t CRateLimiter::Refill(uint64_t nState, uint32_t nNowMs) const
+{
+	int32_t nTokens = (int32_t)(nState >> 32);
+	uint32_t nElapsed = nNowMs - (uint32_t)nState;
+	int32_t nBurst = m_nBurst.load(std::memory_order_relaxed);
+
+	// Wraps after ~49 days, treat anything that far apart as idle
+	if(nElapsed > 0x7FFFFFFF)
+		return nBurst;
+
+	int64_t nRefilled = (int64_t)nTokens + (int64_t)nElapsed * m_nRefill.load(std::memory_order_relaxed) / 1000;
+	return nRefilled > nBurst ? nBurst : (int32_t)nRefilled;
+}
+
+CRateLimiter::Bucket *CRateLimiter::Find(uint32_t nAddress, uint32_t nNowMs, bool bCreate)
+{
+	uint32_t nHash = nAddress * 2654435761u;
+	Bucket *pIdle = NULL;
+
+	for(uint32_t i = 0; i < RATELIMIT_MAX_PROBES; i++)
+	{
+		Bucket *pBucket = &m_Buckets[(nHash + i) & (RATELIMIT_TABLE_SIZE - 1)];
+		uint32_t nKey = pBucket->nAddress.load(std::memory_order_acquire);
+		if(nKey == nAddress)
+			return pBucket;
+
+		if(!nKey)
+		{
+			if(!bCreate)
+				return NULL;
+
+			// New buckets start full
+			pBucket->nState.store(MakeState(m_nBurst.load(std::memory_order_relaxed), nNowMs), std::memory_order_relaxed);
+			if(pBucket->nAddress.compare_exchange_strong(nKey, nAddress, std::memory_order_acq_rel))
+				return pBucket;
+
+			// Lost the race, maybe to the same address
+			if(nKey == nAddress)
+				return pBucket;
+			continue;
+		}
+
+		if(!pIdle)
+		{
+			uint64_t nState = pBucket->nState.load(std::memory_order_relaxed);
+			if(nNowMs - (uint32_t)nState > RATELIMIT_IDLE_MS && Refill(nState, nNowMs) >= m_nBurst.load(std::memory_order_relaxed))
+				pIdle = pBucket;
+		}
+	}
+
+	if(!bCreate || !pIdle)
+		return NULL;
+
+	// Evict a forgiven source, its bucket was full anyway
+	uint32_t nKey = pIdle->nAddress.load(std::memory_order_relaxed);
+	pIdle->nState.store(MakeState(m_nBurst.load(std::memory_order_relaxed), nNowMs), std::memory_order_relaxed);
+	if(pIdle->nAddress.compare_exchange_strong(nKey, nAddress, std::memory_order_acq_rel))
+		return pIdle;
+
+	return NULL;
+}
+
+bool CRateLimiter::IsBlocked(uint32_t nAddress, uint32_t nNowMs)
+{
+	Bucket *pBucket = Find(nAddress, nNowMs, false);
+	if(!pBucket)
+		return false;
+
+	if(Refill(pBucket->nState.load(std::memory_order_relaxed), nNowMs) >= RATELIMIT_TOKEN)
+		return false;
+
+	m_nBlocked.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void CRateLimiter::Penalize(uint32_t nAddress, uint32_t nNowMs)
+{
+	m_nPenalties.fetch_add(1, std::memory_order_relaxed);
+
+	Bucket *pBucket = Find(nAddress, nNowMs, true);
+	if(!pBucket)
+	{
+		m_nUntracked.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	uint64_t nState = pBucket->nState.load(std::memory_order_relaxed);
+	uint64_t nNewState;
+	do
+	{
+		int32_t nTokens = Refill(nState, nNowMs) - RATELIMIT_TOKEN;
+		if(nTokens < 0)
+			nTokens = 0;
+
+		nNewState = MakeState(nTokens, nNowMs);
+	}
+	while(!pBucket->nState.compare_exchange_weak(nState, nNewState, std::memory_order_relaxed));
+}
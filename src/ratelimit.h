@@ -0,0 +1,93 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_RATELIMIT_H_
+#define _INCLUDE_CSSFIXES_RATELIMIT_H_
+
+/**
+ * @file ratelimit.h
+ * @brief Per source address token buckets for packets failing header checks.
+ *
+ * Every failure costs a token, a source without tokens left is blocked
+ * until enough refilled. Buckets live in a fixed size open addressing table,
+ * the state of each bucket is one 64 bit word (tokens, last update) updated
+ * with compare-and-swap, so no locks are taken on the packet path.
+ * Time is passed in by the caller, which keeps it testable offline.
+ */
+
+#include <stdint.h>
+#include <atomic>
+
+#define RATELIMIT_TABLE_SIZE	4096	// power of two
+#define RATELIMIT_MAX_PROBES	16
+// A bucket that is full and wasn't touched for this long can be reused
+#define RATELIMIT_IDLE_MS		10000
+
+class CRateLimiter
+{
+public:
+	CRateLimiter();
+
+	// flBurst failures in a row are allowed, flRefill failures per second are forgiven
+	void Configure(float flBurst, float flRefill);
+	void Reset();
+
+	bool IsBlocked(uint32_t nAddress, uint32_t nNowMs);
+	// Charge one failed header check
+	void Penalize(uint32_t nAddress, uint32_t nNowMs);
+
+public:
+	std::atomic<uint64_t> m_nBlocked;		// packets dropped early
+	std::atomic<uint64_t> m_nPenalties;
+	std::atomic<uint64_t> m_nUntracked;		// no bucket available, let through
+
+private:
+	struct Bucket
+	{
+		std::atomic<uint32_t> nAddress;
+		std::atomic<uint64_t> nState;		// tokens in 1/1000 << 32 | last update in ms
+	};
+
+	Bucket *Find(uint32_t nAddress, uint32_t nNowMs, bool bCreate);
+	int32_t Refill(uint64_t nState, uint32_t nNowMs) const;
+
+	static inline uint64_t MakeState(int32_t nTokens, uint32_t nTimeMs)
+	{
+		return ((uint64_t)(uint32_t)nTokens << 32) | nTimeMs;
+	}
+
+private:
+	Bucket m_Buckets[RATELIMIT_TABLE_SIZE];
+	std::atomic<int32_t> m_nBurst;			// tokens in 1/1000
+	std::atomic<int32_t> m_nRefill;			// 1/1000 tokens per second
+};
+
+#endif // _INCLUDE_CSSFIXES_RATELIMIT_H_
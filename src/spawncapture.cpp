@@ -0,0 +1,145 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "spawncapture.h"
+
+CSpawnCaptureWriter::CSpawnCaptureWriter() : m_pFile(NULL), m_iTick(-1), m_nNextEntity(0)
+{
+}
+
+CSpawnCaptureWriter::~CSpawnCaptureWriter()
+{
+	Close();
+}
+
+bool CSpawnCaptureWriter::Open(const char *pszPath, const char *pszMap)
+{
+	Close();
+
+	m_pFile = fopen(pszPath, "wb");
+	if(!m_pFile)
+		return false;
+
+	// Streamed out in big chunks, this is on the game thread
+	setvbuf(m_pFile, NULL, _IOFBF, 1 << 16);
+
+	size_t length = strlen(pszMap);
+	fwrite(SPAWNCAPTURE_MAGIC, 4, 1, m_pFile);
+	fputc(SPAWNCAPTURE_VERSION, m_pFile);
+	WriteVarint((uint32_t)length);
+	fwrite(pszMap, length, 1, m_pFile);
+	return true;
+}
+
+void CSpawnCaptureWriter::Close()
+{
+	if(m_pFile)
+		fclose(m_pFile);
+
+	m_pFile = NULL;
+	m_iTick = -1;
+	m_nNextEntity = 0;
+	m_Strings.clear();
+	m_Entities.clear();
+}
+
+void CSpawnCaptureWriter::Create(const void *pEntity, const char *pszClassname, int iTick)
+{
+	if(!m_pFile)
+		return;
+
+	uint32_t nClassname = Intern(pszClassname);
+	uint32_t nEntity = m_nNextEntity++;
+	m_Entities[pEntity] = nEntity;
+
+	SetTick(iTick);
+	fputc(SpawnRecord_Create, m_pFile);
+	WriteVarint(nEntity);
+	WriteVarint(nClassname);
+}
+
+void CSpawnCaptureWriter::KeyValue(const void *pEntity, const char *pszClassname, const char *pszKey, const char *pszValue, int iTick)
+{
+	if(!m_pFile)
+		return;
+
+	std::unordered_map<const void *, uint32_t>::iterator it = m_Entities.find(pEntity);
+	if(it == m_Entities.end())
+	{
+		Create(pEntity, pszClassname ? pszClassname : "", iTick);
+		it = m_Entities.find(pEntity);
+	}
+
+	uint32_t nKey = Intern(pszKey);
+	uint32_t nValue = Intern(pszValue);
+
+	SetTick(iTick);
+	fputc(SpawnRecord_KeyValue, m_pFile);
+	WriteVarint(it->second);
+	WriteVarint(nKey);
+	WriteVarint(nValue);
+}
+
+void CSpawnCaptureWriter::WriteVarint(uint32_t value)
+{
+	while(value >= 0x80)
+	{
+		fputc((int)(value & 0x7F) | 0x80, m_pFile);
+		value >>= 7;
+	}
+	fputc((int)value, m_pFile);
+}
+
+uint32_t CSpawnCaptureWriter::Intern(const char *pszString)
+{
+	std::unordered_map<std::string, uint32_t>::iterator it = m_Strings.find(pszString);
+	if(it != m_Strings.end())
+		return it->second;
+
+	uint32_t nId = (uint32_t)m_Strings.size();
+	m_Strings[pszString] = nId;
+
+	size_t length = strlen(pszString);
+	fputc(SpawnRecord_String, m_pFile);
+	WriteVarint((uint32_t)length);
+	fwrite(pszString, length, 1, m_pFile);
+	return nId;
+}
+
+void CSpawnCaptureWriter::SetTick(int iTick)
+{
+	if(iTick == m_iTick)
+		return;
+
+	m_iTick = iTick;
+	fputc(SpawnRecord_Tick, m_pFile);
+	WriteVarint((uint32_t)iTick);
+}
@@ -0,0 +1,239 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_SPAWNCAPTURE_H_
+#define _INCLUDE_CSSFIXES_SPAWNCAPTURE_H_
+
+/**
+ * @file spawncapture.h
+ * @brief Streaming capture of the (classname, key, value) traffic seen by
+ * DETOUR_CreateEntityByName and DETOUR_KeyValue, and a reader to replay it.
+ *
+ * File layout:
+ *   "CSKV", version byte, map name (varint length + bytes)
+ *   records, each starting with a type byte:
+ *     SpawnRecord_String    varint length + bytes, gets the next string id (0, 1, 2, ...)
+ *     SpawnRecord_Tick      varint tick, applies to all following records
+ *     SpawnRecord_Create    varint entity id, varint classname string id
+ *     SpawnRecord_KeyValue  varint entity id, varint key string id, varint value string id
+ *
+ * Every string is written once, later references use its id.
+ * Entity ids are assigned in capture order, ids are never reused,
+ * an entity created again (same edict or address) gets a new id.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define SPAWNCAPTURE_MAGIC		"CSKV"
+#define SPAWNCAPTURE_VERSION	1
+
+enum SpawnRecordType
+{
+	SpawnRecord_String = 'S',
+	SpawnRecord_Tick = 'T',
+	SpawnRecord_Create = 'C',
+	SpawnRecord_KeyValue = 'K',
+};
+
+struct SpawnRecord
+{
+	SpawnRecordType type;
+	int iTick;
+	uint32_t nEntity;
+	const char *pszClassname;	// SpawnRecord_Create
+	const char *pszKey;			// SpawnRecord_KeyValue
+	const char *pszValue;		// SpawnRecord_KeyValue
+};
+
+class CSpawnCaptureReader
+{
+public:
+	CSpawnCaptureReader() : m_pFile(NULL), m_iTick(0)
+	{
+	}
+
+	~CSpawnCaptureReader()
+	{
+		Close();
+	}
+
+	bool Open(const char *pszPath)
+	{
+		Close();
+		m_pFile = fopen(pszPath, "rb");
+		if(!m_pFile)
+			return false;
+
+		char magic[4];
+		if(fread(magic, sizeof(magic), 1, m_pFile) != 1 || memcmp(magic, SPAWNCAPTURE_MAGIC, sizeof(magic)) != 0 ||
+			fgetc(m_pFile) != SPAWNCAPTURE_VERSION || !ReadString(m_Map))
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+		if(m_pFile)
+			fclose(m_pFile);
+		m_pFile = NULL;
+		m_Strings.clear();
+		m_iTick = 0;
+	}
+
+	const char *GetMap() const
+	{
+		return m_Map.c_str();
+	}
+
+	// Returns false at the end of the stream or on a corrupt record
+	bool Next(SpawnRecord &record)
+	{
+		uint32_t a, b, c;
+		for(;;)
+		{
+			int type = m_pFile ? fgetc(m_pFile) : EOF;
+			switch(type)
+			{
+			case SpawnRecord_String:
+			{
+				std::string str;
+				if(!ReadString(str))
+					return false;
+				m_Strings.push_back(str);
+				continue;
+			}
+
+			case SpawnRecord_Tick:
+				if(!ReadVarint(a))
+					return false;
+				m_iTick = (int)a;
+				continue;
+
+			case SpawnRecord_Create:
+				if(!ReadVarint(a) || !ReadVarint(b) || b >= m_Strings.size())
+					return false;
+				record.type = SpawnRecord_Create;
+				record.iTick = m_iTick;
+				record.nEntity = a;
+				record.pszClassname = m_Strings[b].c_str();
+				record.pszKey = record.pszValue = NULL;
+				return true;
+
+			case SpawnRecord_KeyValue:
+				if(!ReadVarint(a) || !ReadVarint(b) || !ReadVarint(c) || b >= m_Strings.size() || c >= m_Strings.size())
+					return false;
+				record.type = SpawnRecord_KeyValue;
+				record.iTick = m_iTick;
+				record.nEntity = a;
+				record.pszClassname = NULL;
+				record.pszKey = m_Strings[b].c_str();
+				record.pszValue = m_Strings[c].c_str();
+				return true;
+
+			default:
+				return false;
+			}
+		}
+	}
+
+private:
+	bool ReadVarint(uint32_t &value)
+	{
+		value = 0;
+		for(int shift = 0; shift < 35; shift += 7)
+		{
+			int byte = fgetc(m_pFile);
+			if(byte == EOF)
+				return false;
+
+			value |= (uint32_t)(byte & 0x7F) << shift;
+			if(!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	bool ReadString(std::string &str)
+	{
+		uint32_t length;
+		if(!ReadVarint(length) || length > 0x10000)
+			return false;
+
+		str.resize(length);
+		return !length || fread(&str[0], length, 1, m_pFile) == 1;
+	}
+
+private:
+	FILE *m_pFile;
+	int m_iTick;
+	std::string m_Map;
+	std::vector<std::string> m_Strings;
+};
+
+#ifndef SPAWNCAPTURE_READER_ONLY
+class CSpawnCaptureWriter
+{
+public:
+	CSpawnCaptureWriter();
+	~CSpawnCaptureWriter();
+
+	bool Open(const char *pszPath, const char *pszMap);
+	void Close();
+	bool IsOpen() const { return m_pFile != NULL; }
+
+	void Create(const void *pEntity, const char *pszClassname, int iTick);
+	// pszClassname is only used if the entity was created before the capture started
+	void KeyValue(const void *pEntity, const char *pszClassname, const char *pszKey, const char *pszValue, int iTick);
+
+private:
+	void WriteVarint(uint32_t value);
+	uint32_t Intern(const char *pszString);
+	void SetTick(int iTick);
+
+private:
+	FILE *m_pFile;
+	int m_iTick;
+	uint32_t m_nNextEntity;
+	std::unordered_map<std::string, uint32_t> m_Strings;
+	std::unordered_map<const void *, uint32_t> m_Entities;
+};
+#endif
+
+#endif // _INCLUDE_CSSFIXES_SPAWNCAPTURE_H_
@@ -0,0 +1,95 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "statspage.h"
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static StatsPage *s_pPage = NULL;
+
+StatsPage *StatsPage_Open(const char *pszPath)
+{
+	StatsPage_Close();
+
+#ifdef _WIN32
+	return NULL;
+#else
+	int fd = open(pszPath, O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+		return NULL;
+
+	if(ftruncate(fd, sizeof(StatsPage)) != 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	void *pMemory = mmap(NULL, sizeof(StatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(pMemory == MAP_FAILED)
+		return NULL;
+
+	s_pPage = (StatsPage *)pMemory;
+
+	// Readers ignore the page until the header is complete
+	__atomic_store_n(&s_pPage->nMagic, 0, __ATOMIC_RELAXED);
+	memset(s_pPage, 0, sizeof(StatsPage));
+	s_pPage->nVersion = STATSPAGE_VERSION;
+	s_pPage->nSize = sizeof(StatsPage);
+	__atomic_store_n(&s_pPage->nMagic, STATSPAGE_MAGIC, __ATOMIC_RELEASE);
+
+	return s_pPage;
+#endif
+}
+
+void StatsPage_Close()
+{
+#ifndef _WIN32
+	if(s_pPage)
+		munmap(s_pPage, sizeof(StatsPage));
+#endif
+	s_pPage = NULL;
+}
+
+void StatsPage_BeginWrite(StatsPage *pPage)
+{
+	__atomic_store_n(&pPage->nSequence, pPage->nSequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void StatsPage_EndWrite(StatsPage *pPage)
+{
+	__atomic_store_n(&pPage->nSequence, pPage->nSequence + 1, __ATOMIC_RELEASE);
+}
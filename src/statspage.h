@@ -0,0 +1,163 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_STATSPAGE_H_
+#define _INCLUDE_CSSFIXES_STATSPAGE_H_
+
+/**
+ * @file statspage.h
+ * @brief Fixed layout counters published into a memory mapped file for
+ * external monitoring, without going through the server console.
+ *
+ * The game thread updates the page under a seqlock. Readers must:
+ *   1. read nSequence, retry if it is odd
+ *   2. copy the page
+ *   3. read nSequence again, retry if it changed
+ * and check nMagic/nVersion/nSize before trusting the layout.
+ */
+
+#include <stdint.h>
+
+#define STATSPAGE_MAGIC			0x53465343	// "CSFS"
+#define STATSPAGE_VERSION		15
+#define STATSPAGE_MAX_HOOKS		32
+#define STATSPAGE_NAME_LENGTH	32
+
+#pragma pack(push, 8)
+struct StatsPageHook
+{
+	char szName[STATSPAGE_NAME_LENGTH];
+	uint64_t nCalls;
+	uint64_t nTotalCycles;
+	uint64_t nMaxCycles;
+};
+
+struct StatsPage
+{
+	uint32_t nMagic;
+	uint32_t nVersion;
+	uint32_t nSize;						// sizeof(StatsPage) of the writer
+	uint32_t nSequence;					// seqlock, odd while an update is in progress
+
+	int64_t nUpdateTime;				// unix time of the last update
+	int32_t iTick;
+	int32_t bProfiling;					// hook counters only move while sv_cssfixes_profile is 1
+	double flMicrosecondsPerCycle;
+
+	uint32_t nHooks;
+	uint32_t _pad0;
+	StatsPageHook hooks[STATSPAGE_MAX_HOOKS];
+
+	uint64_t nEdictsSaved;				// entities made EFL_SERVER_ONLY by PostConstructor
+	uint32_t nPatches;					// configured patches
+	uint32_t nPatchesApplied;			// patched sites, a patch can apply to more than one
+	uint64_t nTraceFilterChecks;		// ShouldHitEntity calls inside FireBullets/SwingOrStab
+	uint64_t nTraceFilterPassThrough;	// of which were made to pass through the entity
+
+	// Version 2
+	uint64_t nEventsCoalesceChecked;	// allow-listed events seen by sv_cssfixes_coalesce_events this map
+	uint64_t nEventsCoalesced;			// of which were dropped as duplicates
+
+	// Version 3
+	uint64_t nNetHeaderMessages;		// ProcessPacketHeader/NET_GetLong messages counted instead of printed
+
+	// Version 4
+	uint64_t nNetLimitPenalties;		// malformed split packets charged by sv_cssfixes_netlimit
+	uint64_t nNetLimitDropped;			// packets dropped from blocked sources
+
+	// Version 5
+	uint64_t nUserInfoSuppressed;		// userinfo updates held back by sv_cssfixes_userinfo_interval
+	uint64_t nUserInfoBytesSaved;		// their size times the clients they'd have been sent to
+
+	// Version 6
+	uint64_t nPakCacheHits;				// CZipPackFile::GetFileInfo answered by sv_cssfixes_pakcache this map
+	uint64_t nPakCacheMisses;
+
+	// Version 7
+	uint64_t nKeyValueRulesChecked;		// keyvalues looked up in the rules compiled for this map
+	uint64_t nKeyValueRulesApplied;		// of which a rule set, renamed or dropped
+
+	// Version 8, sv_cssfixes_entpool was removed, always 0
+	uint64_t nEntPoolHits;
+	uint64_t nEntPoolMisses;
+	uint64_t nEntPoolRecycled;
+	uint64_t nEntPoolKept;
+
+	// Version 9
+	uint64_t nFactoryCacheHits;			// CreateEntityByName calls answered by the factory cache this map
+	uint64_t nFactoryCacheClasses;		// classnames in the cache
+
+	// Version 10
+	uint64_t nEdicts;					// used edicts
+	uint64_t nEdictPressureAllowed;		// sv_cssfixes_edict_pressure spawns above the watermark let through on the budget this map
+	uint64_t nEdictPressureServerOnly;	// made server only
+	uint64_t nEdictPressureRefused;		// refused
+
+	// Version 11
+	uint64_t nHudMsgQueued;				// game_text messages held back by sv_cssfixes_hudmsg_coalesce this map
+	uint64_t nHudMsgReplaced;			// dropped for a later one in the same tick
+	uint64_t nHudMsgSuppressed;			// identical to the one still on screen
+	uint64_t nHudMsgBytesSaved;			// user message bytes not sent, times recipients
+
+	// Version 12
+	uint64_t nCmdQueueDepth;			// point_server/clientcommand commands waiting in sv_cssfixes_cmdqueue
+	uint64_t nCmdQueueMaxDepth;			// deepest the queue got this map
+	uint64_t nCmdQueued;
+	uint64_t nCmdDeduplicated;			// dropped as identical to a pending one
+	uint64_t nCmdExecuted;
+
+	// Version 13
+	uint64_t nTeleports;				// point_teleport "!activator" player teleports seen by sv_cssfixes_teleport_batch this map
+	uint64_t nTeleportsBatched;			// after the first to the same spot in the same tick
+	uint64_t nTeleportsSpread;			// moved off the destination by sv_cssfixes_teleport_spread
+	uint64_t nTeleportsDeduplicated;	// dropped, the player was already sent there this tick
+
+	// Version 14
+	uint64_t nViewControlChecks;		// point_viewcontrol per client transmit checks by sv_cssfixes_viewcontrol_transmit this map
+	uint64_t nViewControlSent;			// of which sent, the rest left out of the snapshot
+
+	// Version 15
+	uint64_t nGameUIParked;				// idle game_ui thinks stopped by sv_cssfixes_gameui_events this map
+	uint64_t nGameUIWoken;				// woken up again by a button change
+};
+#pragma pack(pop)
+
+#ifndef STATSPAGE_FORMAT_ONLY
+// Creates/maps the page at pszPath, returns NULL on failure
+StatsPage *StatsPage_Open(const char *pszPath);
+void StatsPage_Close();
+
+// Wrap every update of the page in these
+void StatsPage_BeginWrite(StatsPage *pPage);
+void StatsPage_EndWrite(StatsPage *pPage);
+#endif
+
+#endif // _INCLUDE_CSSFIXES_STATSPAGE_H_
@@ -0,0 +1,201 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "teleport.h"
+#include <math.h>
+
+CTeleportBatch::CTeleportBatch() : m_nTeleports(0), m_nDeduplicated(0), m_nBatched(0), m_nSpread(0), m_nLargestBatch(0),
+	m_iTick(-1), m_nDestinations(0), m_nLast(0)
+{
+}
+
+static inline void RoundOrigin(const float vec[3], int32_t vecRounded[3])
+{
+	for(int i = 0; i < 3; i++)
+		vecRounded[i] = (int32_t)floorf(vec[i] + 0.5f);
+}
+
+static inline bool SameOrigin(const int32_t a[3], const int32_t b[3])
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+CTeleportBatch::Destination *CTeleportBatch::FindDestination(const int32_t vecOrigin[3])
+{
+	for(size_t i = 0; i < m_nDestinations; i++)
+	{
+		if(SameOrigin(m_Destinations[i].vecOrigin, vecOrigin))
+			return &m_Destinations[i];
+	}
+
+	return NULL;
+}
+
+CTeleportBatch::LastTeleport *CTeleportBatch::FindLast(uint32_t iTarget)
+{
+	for(size_t i = 0; i < m_nLast; i++)
+	{
+		if(m_Last[i].iTarget == iTarget)
+			return &m_Last[i];
+	}
+
+	return NULL;
+}
+
+bool CTeleportBatch::Add(int iTick, const float vecDest[3], const float vecAngles[3], uint32_t iTarget, const float vecCurrent[3], int *pSlot)
+{
+	if(iTick != m_iTick)
+	{
+		m_iTick = iTick;
+		m_nDestinations = 0;
+		m_nLast = 0;
+	}
+
+	int32_t vecOrigin[3], vecRoundedAngles[3];
+	RoundOrigin(vecDest, vecOrigin);
+	RoundOrigin(vecAngles, vecRoundedAngles);
+
+	LastTeleport *pLast = FindLast(iTarget);
+	if(pLast && SameOrigin(pLast->vecOrigin, vecOrigin) && SameOrigin(pLast->vecAngles, vecRoundedAngles) &&
+		fabsf(vecCurrent[0] - pLast->vecLanded[0]) <= 1.0f &&
+		fabsf(vecCurrent[1] - pLast->vecLanded[1]) <= 1.0f &&
+		fabsf(vecCurrent[2] - pLast->vecLanded[2]) <= 1.0f)
+	{
+		m_nDeduplicated++;
+		return false;
+	}
+
+	if(!pLast)
+	{
+		if(m_nLast == m_Last.size())
+			m_Last.push_back(LastTeleport());
+
+		pLast = &m_Last[m_nLast++];
+		pLast->iTarget = iTarget;
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		pLast->vecOrigin[i] = vecOrigin[i];
+		pLast->vecAngles[i] = vecRoundedAngles[i];
+		pLast->vecLanded[i] = vecDest[i];
+	}
+
+	Destination *pDest = FindDestination(vecOrigin);
+	if(!pDest)
+	{
+		if(m_nDestinations == m_Destinations.size())
+			m_Destinations.push_back(Destination());
+
+		pDest = &m_Destinations[m_nDestinations++];
+		pDest->vecOrigin[0] = vecOrigin[0];
+		pDest->vecOrigin[1] = vecOrigin[1];
+		pDest->vecOrigin[2] = vecOrigin[2];
+		pDest->targets.clear();
+	}
+
+	m_nTeleports++;
+
+	// Back to a destination it already had a slot at
+	for(size_t i = 0; i < pDest->targets.size(); i++)
+	{
+		if(pDest->targets[i] == iTarget)
+		{
+			*pSlot = (int)i;
+			return true;
+		}
+	}
+
+	*pSlot = (int)pDest->targets.size();
+	pDest->targets.push_back(iTarget);
+
+	if(*pSlot)
+		m_nBatched++;
+	if(*pSlot + 1 > m_nLargestBatch)
+		m_nLargestBatch = *pSlot + 1;
+
+	return true;
+}
+
+void CTeleportBatch::Landed(uint32_t iTarget, const float vecOrigin[3])
+{
+	LastTeleport *pLast = FindLast(iTarget);
+	if(!pLast)
+		return;
+
+	pLast->vecLanded[0] = vecOrigin[0];
+	pLast->vecLanded[1] = vecOrigin[1];
+	pLast->vecLanded[2] = vecOrigin[2];
+}
+
+void CTeleportBatch::Reset()
+{
+	m_iTick = -1;
+	m_nDestinations = 0;
+	m_nLast = 0;
+	m_nTeleports = 0;
+	m_nDeduplicated = 0;
+	m_nBatched = 0;
+	m_nSpread = 0;
+	m_nLargestBatch = 0;
+}
+
+void CTeleportBatch::SpreadOffset(int iSlot, float flSpacing, float vecOffset[2])
+{
+	vecOffset[0] = 0.0f;
+	vecOffset[1] = 0.0f;
+	if(iSlot <= 0)
+		return;
+
+	// Find the ring, ring r starts at slot (2r - 1)^2
+	int r = 1;
+	int iFirst = 1;
+	while(iSlot >= iFirst + 8 * r)
+	{
+		iFirst += 8 * r;
+		r++;
+	}
+
+	// Walk its sides, 2r slots each
+	int k = iSlot - iFirst;
+	int iPos = k % (2 * r);
+	int x, y;
+	switch(k / (2 * r))
+	{
+		case 0: x = -r + iPos; y = -r; break;
+		case 1: x = r; y = -r + iPos; break;
+		case 2: x = r - iPos; y = r; break;
+		default: x = -r; y = r - iPos; break;
+	}
+
+	vecOffset[0] = x * flSpacing;
+	vecOffset[1] = y * flSpacing;
+}
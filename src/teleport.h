@@ -0,0 +1,105 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_TELEPORT_H_
+#define _INCLUDE_CSSFIXES_TELEPORT_H_
+
+/**
+ * @file teleport.h
+ * @brief Per tick bookkeeping of point_teleport destinations.
+ *
+ * Teleports landing on the same spot during one tick form a batch, each
+ * entity gets the next slot of the batch, or the one it already has there.
+ * A teleport is only reported as a duplicate when the entity's last one of
+ * the tick went to the same spot with the same angles and the entity is
+ * still where that one put it, so whatever moved it in between (another
+ * destination, a trigger_teleport) isn't undone by dropping the repeat.
+ *
+ * Slots map to a square spiral around the destination, slot 0 is the
+ * destination itself, ring r holds the 8r slots r steps away.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class CTeleportBatch
+{
+public:
+	CTeleportBatch();
+
+	/**
+	 * Returns false if the last teleport of iTarget during iTick went to vecDest with vecAngles
+	 * and vecCurrent is where it landed, otherwise its slot is in *pSlot and it is assumed
+	 * to land on vecDest until Landed says otherwise.
+	 */
+	bool Add(int iTick, const float vecDest[3], const float vecAngles[3], uint32_t iTarget, const float vecCurrent[3], int *pSlot);
+	// iTarget's last teleport put it elsewhere than its destination (spread)
+	void Landed(uint32_t iTarget, const float vecOrigin[3]);
+
+	void Reset();
+
+	// XY offset of iSlot, flSpacing units per step
+	static void SpreadOffset(int iSlot, float flSpacing, float vecOffset[2]);
+
+public:
+	uint64_t m_nTeleports;
+	uint64_t m_nDeduplicated;
+	uint64_t m_nBatched;		// teleports after the first to a destination in the same tick
+	uint64_t m_nSpread;			// set by the caller, moved off the destination
+	int m_nLargestBatch;
+
+private:
+	struct Destination
+	{
+		int32_t vecOrigin[3];	// whole units, destinations this close are the same spot
+		std::vector<uint32_t> targets;
+	};
+
+	struct LastTeleport
+	{
+		uint32_t iTarget;
+		int32_t vecOrigin[3];	// rounded like Destination
+		int32_t vecAngles[3];
+		float vecLanded[3];
+	};
+
+	Destination *FindDestination(const int32_t vecOrigin[3]);
+	LastTeleport *FindLast(uint32_t iTarget);
+
+	int m_iTick;
+	size_t m_nDestinations;		// used this tick, the rest are kept for their allocations
+	std::vector<Destination> m_Destinations;
+	size_t m_nLast;				// same for the last teleport of each target
+	std::vector<LastTeleport> m_Last;
+};
+
+#endif // _INCLUDE_CSSFIXES_TELEPORT_H_
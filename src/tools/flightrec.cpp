@@ -0,0 +1,151 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+/**
+ * @file flightrec.cpp
+ * @brief Decoder for the flight recorder dumps written on frame time spikes.
+ *
+ * Usage: CSSFixes.flightrec [--csv] <cssfixes_spike_*.bin>
+ */
+
+#define FLIGHTREC_FORMAT_ONLY
+#include "flightrecorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+	bool bCSV = false;
+	const char *pszPath = NULL;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--csv") == 0)
+			bCSV = true;
+		else
+			pszPath = argv[i];
+	}
+
+	if(!pszPath)
+	{
+		fprintf(stderr, "Usage: %s [--csv] <cssfixes_spike_*.bin>\n", argv[0]);
+		return 1;
+	}
+
+	FILE *pFile = fopen(pszPath, "rb");
+	if(!pFile)
+	{
+		fprintf(stderr, "Could not open %s\n", pszPath);
+		return 1;
+	}
+
+	FlightRecHeader header;
+	if(fread(&header, sizeof(header), 1, pFile) != 1 || memcmp(header.szMagic, FLIGHTREC_MAGIC, sizeof(header.szMagic)) != 0)
+	{
+		fprintf(stderr, "%s is not a flight recorder dump\n", pszPath);
+		fclose(pFile);
+		return 1;
+	}
+
+	if(header.nVersion != FLIGHTREC_VERSION)
+	{
+		fprintf(stderr, "Unsupported flight recorder version %u (expected %u)\n", header.nVersion, FLIGHTREC_VERSION);
+		fclose(pFile);
+		return 1;
+	}
+
+	std::vector<std::vector<char> > names(header.nHooks, std::vector<char>(FLIGHTREC_NAME_LENGTH + 1, 0));
+	for(uint32_t i = 0; i < header.nHooks; i++)
+	{
+		if(fread(names[i].data(), FLIGHTREC_NAME_LENGTH, 1, pFile) != 1)
+		{
+			fprintf(stderr, "Truncated hook names\n");
+			fclose(pFile);
+			return 1;
+		}
+	}
+
+	header.szMap[sizeof(header.szMap) - 1] = '\0';
+	time_t when = (time_t)header.nTime;
+
+	if(bCSV)
+	{
+		printf("frame,spike,tick,frame_ms");
+		for(uint32_t i = 0; i < header.nHooks; i++)
+			printf(",%s_us,%s_calls", names[i].data(), names[i].data());
+		printf("\n");
+	}
+	else
+	{
+		printf("map %s, %u frames, spike at frame %u over %.2f ms, written %s",
+			header.szMap, header.nFrames, header.nSpikeFrame, header.flThresholdMs, ctime(&when));
+	}
+
+	std::vector<FlightRecHook> hooks(header.nHooks);
+	for(uint32_t f = 0; f < header.nFrames; f++)
+	{
+		FlightRecFrame frame;
+		if(fread(&frame, sizeof(frame), 1, pFile) != 1 ||
+			(header.nHooks && fread(hooks.data(), sizeof(FlightRecHook), header.nHooks, pFile) != header.nHooks))
+		{
+			fprintf(stderr, "Truncated at frame %u\n", f);
+			fclose(pFile);
+			return 1;
+		}
+
+		bool bSpike = f == header.nSpikeFrame;
+		if(bCSV)
+		{
+			printf("%u,%d,%d,%.3f", f, bSpike, frame.iTick, frame.flFrameMs);
+			for(uint32_t i = 0; i < header.nHooks; i++)
+				printf(",%.3f,%u", hooks[i].flMicroseconds, hooks[i].nCalls);
+			printf("\n");
+			continue;
+		}
+
+		float flHooksMs = 0.0f;
+		for(uint32_t i = 0; i < header.nHooks; i++)
+			flHooksMs += hooks[i].flMicroseconds / 1000.0f;
+
+		printf("%c %4u tick %8d %8.3f ms, hooks %7.3f ms", bSpike ? '*' : ' ', f, frame.iTick, frame.flFrameMs, flHooksMs);
+		for(uint32_t i = 0; i < header.nHooks; i++)
+		{
+			if(hooks[i].nCalls)
+				printf(" | %s %.1f us (%u)", names[i].data(), hooks[i].flMicroseconds, hooks[i].nCalls);
+		}
+		printf("\n");
+	}
+
+	fclose(pFile);
+	return 0;
+}
@@ -0,0 +1,319 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#include "utils.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <strings.h>
+
+uintptr_t FindPattern(uintptr_t BaseAddr, const unsigned char *pData, const char *pPattern, size_t MaxSize)
+{
+	unsigned char *pMemory;
+	uintptr_t PatternLen = strlen(pPattern);
+
+	pMemory = reinterpret_cast<unsigned char *>(BaseAddr);
+
+	for(uintptr_t i = 0; i < MaxSize; i++)
+	{
+		uintptr_t Matches = 0;
+		while(*(pMemory + i + Matches) == pData[Matches] || pPattern[Matches] != 'x')
+		{
+			Matches++;
+			if(Matches == PatternLen)
+				return (uintptr_t)(pMemory + i);
+		}
+	}
+
+	return 0x00;
+}
+
+uintptr_t FindFunctionCall(uintptr_t BaseAddr, uintptr_t Function, size_t MaxSize)
+{
+	unsigned char *pMemory;
+	pMemory = reinterpret_cast<unsigned char *>(BaseAddr);
+
+	for(uintptr_t i = 0; i < MaxSize; i++)
+	{
+		if(pMemory[i] == 0xE8) // CALL
+		{
+			// rel32, relative to the next instruction
+			uintptr_t CallAddr = (uintptr_t)(intptr_t)*(int32_t *)(pMemory + i + 1);
+
+			CallAddr += (uintptr_t)(pMemory + i + 5);
+
+			if(CallAddr == Function)
+				return (uintptr_t)(pMemory + i);
+
+			i += 4;
+		}
+	}
+
+	return 0x00;
+}
+
+void UTIL_StringToVector( float *pVector, const char *pString )
+{
+	char *pstr, *pfront, tempString[128];
+	int	j;
+
+	strncpy( tempString, pString, sizeof(tempString) - 1 );
+	tempString[sizeof(tempString) - 1] = '\0';
+	pstr = pfront = tempString;
+
+	for ( j = 0; j < 3; j++ )			// lifted from pr_edict.c
+	{
+		pVector[j] = atof( pfront );
+
+		// skip any leading whitespace
+		while ( *pstr && *pstr <= ' ' )
+			pstr++;
+
+		// skip to next whitespace
+		while ( *pstr && *pstr > ' ' )
+			pstr++;
+
+		if (!*pstr)
+			break;
+
+		pstr++;
+		pfront = pstr;
+	}
+	for ( j++; j < 3; j++ )
+	{
+		pVector[j] = 0;
+	}
+}
+
+const char *pszNonEdicts[] =
+{
+	"game_score",
+	"game_text",
+	"game_ui",
+	"logic_auto",	// bruh
+	"phys_thruster",
+	"phys_keepupright",
+	"player_speedmod",
+	"player_weaponstrip",
+	"point_clientcommand",
+	"point_servercommand",
+	"point_teleport",
+};
+
+bool UTIL_IsNonEdictClass(const char *szClassname)
+{
+	for (size_t i = 0; i < sizeof(pszNonEdicts)/sizeof(*pszNonEdicts); i++)
+	{
+		if (!strcasecmp(szClassname, pszNonEdicts[i]))
+			return true;
+	}
+
+	return false;
+}
+
+CNameList::CNameList() : m_nNames(0)
+{
+	m_szList[0] = 0;
+}
+
+bool CNameList::Set(const char *pszList)
+{
+	if(strcmp(m_szList, pszList) == 0)
+		return false;
+
+	strncpy(m_szList, pszList, sizeof(m_szList) - 1);
+	m_szList[sizeof(m_szList) - 1] = 0;
+	m_nNames = 0;
+
+	const char *p = m_szList;
+	while(*p && m_nNames < NAMELIST_MAX_NAMES)
+	{
+		while(*p == ',' || isspace((unsigned char)*p))
+			p++;
+
+		size_t nLength = 0;
+		while(p[nLength] && p[nLength] != ',' && !isspace((unsigned char)p[nLength]))
+			nLength++;
+
+		if(nLength && nLength < NAMELIST_NAME_LENGTH)
+		{
+			memcpy(m_szNames[m_nNames], p, nLength);
+			m_szNames[m_nNames][nLength] = 0;
+			m_nNames++;
+		}
+		p += nLength;
+	}
+
+	return true;
+}
+
+bool CNameList::Contains(const char *pszName) const
+{
+	for(int i = 0; i < m_nNames; i++)
+	{
+		if(strcasecmp(m_szNames[i], pszName) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+KeyValueFix UTIL_FixKeyValue(const char **pszKeyName, const char **pszValue, bool bForceCTSpawn)
+{
+	const char *szKeyName = *pszKeyName;
+
+	// Fix crash bug in engine
+	if(strcasecmp(szKeyName, "angle") == 0)
+	{
+		*pszKeyName = "angles";
+		return KeyValueFix_Angle;
+	}
+	else if(bForceCTSpawn &&
+		strcasecmp(szKeyName, "classname") == 0 &&
+		strcasecmp(*pszValue, "info_player_terrorist") == 0)
+	{
+		// Only CT spawnpoints
+		*pszValue = "info_player_counterterrorist";
+		return KeyValueFix_CTSpawn;
+	}
+	else if(bForceCTSpawn && strcasecmp(szKeyName, "teamnum") == 0)
+	{
+		return KeyValueFix_BuyzoneTeam;
+	}
+	else if(strcasecmp(szKeyName, "absvelocity") == 0)
+	{
+		return KeyValueFix_AbsVelocity;
+	}
+
+	return KeyValueFix_None;
+}
+
+bool UTIL_FixPostConstructor(const char **pszClassname, bool bForceCTSpawn, bool *pbForcedCT)
+{
+	const char *szClassname = *pszClassname;
+	*pbForcedCT = false;
+
+	if(strncasecmp(szClassname, "info_player_", 12) == 0)
+	{
+		// Only CT spawnpoints
+		if(bForceCTSpawn && strcasecmp(szClassname, "info_player_terrorist") == 0)
+		{
+			*pszClassname = "info_player_counterterrorist";
+			*pbForcedCT = true;
+		}
+
+		// Spawnpoints don't need edicts...
+		return true;
+	}
+
+	// Remove edicts for a bunch of entities that REALLY don't need them
+	return UTIL_IsNonEdictClass(szClassname);
+}
+
+CEdictPressure::CEdictPressure() : m_nAllowed(0), m_nServerOnly(0), m_nRefused(0),
+	m_iMode(0), m_iWatermark(0), m_iBudget(0), m_iTick(-1), m_nTickSpawns(0)
+{
+}
+
+void CEdictPressure::Configure(int iMode, int iWatermark, int iBudget)
+{
+	m_iMode = iMode;
+	m_iWatermark = iWatermark;
+	m_iBudget = iBudget > 0 ? iBudget : 0;
+}
+
+EdictPressureAction CEdictPressure::Check(int iTick, int nEdicts)
+{
+	if(!IsEnabled() || nEdicts < m_iWatermark)
+		return EdictPressure_Allow;
+
+	if(iTick != m_iTick)
+	{
+		m_iTick = iTick;
+		m_nTickSpawns = 0;
+	}
+
+	if(m_nTickSpawns < m_iBudget)
+	{
+		m_nTickSpawns++;
+		m_nAllowed++;
+		return EdictPressure_Allow;
+	}
+
+	if(m_iMode >= 2)
+	{
+		m_nRefused++;
+		return EdictPressure_Refuse;
+	}
+
+	m_nServerOnly++;
+	return EdictPressure_ServerOnly;
+}
+
+CParkedThinkers::CParkedThinkers()
+{
+	Clear();
+}
+
+bool CParkedThinkers::Park(int iClient, uint32_t iRef)
+{
+	if(iClient < 0 || iClient >= PARKED_CLIENTS)
+		return false;
+
+	for(int i = 0; i < m_nCount[iClient]; i++)
+	{
+		if(m_Refs[iClient][i] == iRef)
+			return true;
+	}
+
+	if(m_nCount[iClient] >= PARKED_THINKERS_PER_CLIENT)
+		return false;
+
+	m_Refs[iClient][m_nCount[iClient]++] = iRef;
+	m_nTotal++;
+	return true;
+}
+
+void CParkedThinkers::Clear(int iClient)
+{
+	m_nTotal -= m_nCount[iClient];
+	m_nCount[iClient] = 0;
+}
+
+void CParkedThinkers::Clear()
+{
+	memset(m_nCount, 0, sizeof(m_nCount));
+	m_nTotal = 0;
+}
+
+bool UTIL_ContextPasses(const char *szFilterContext, const char *szContext, const char *szValue)
+{
+	return !strcasecmp(szFilterContext, szContext) && atoi(szValue) > 0;
+}
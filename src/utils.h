@@ -0,0 +1,283 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SourceMod Sample Extension
+ * Copyright (C) 2004-2008 AlliedModders LLC.  All rights reserved.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, AlliedModders LLC gives you permission to link the
+ * code of this program (as well as its derivative works) to "Half-Life 2," the
+ * "Source Engine," the "SourcePawn JIT," and any Game MODs that run on software
+ * by the Valve Corporation.  You must obey the GNU General Public License in
+ * all respects for all other code used.  Additionally, AlliedModders LLC grants
+ * this exception to all derivative works.  AlliedModders LLC defines further
+ * exceptions, found in LICENSE.txt (as of this writing, version JULY-31-2007),
+ * or <http://www.sourcemod.net/license.php>.
+ *
+ * Version: $Id$
+*/
+
+#ifndef _INCLUDE_CSSFIXES_UTILS_H_
+#define _INCLUDE_CSSFIXES_UTILS_H_
+
+/**
+ * @file utils.h
+ * @brief SDK independent helpers, shared by the extension and the benchmarks.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+uintptr_t FindPattern(uintptr_t BaseAddr, const unsigned char *pData, const char *pPattern, size_t MaxSize);
+uintptr_t FindFunctionCall(uintptr_t BaseAddr, uintptr_t Function, size_t MaxSize);
+
+void UTIL_StringToVector(float *pVector, const char *pString);
+
+// Entities that REALLY don't need edicts
+bool UTIL_IsNonEdictClass(const char *szClassname);
+
+#define NAMELIST_MAX_NAMES		64
+#define NAMELIST_NAME_LENGTH	64
+
+// Comma separated names from a convar, matched case insensitively
+class CNameList
+{
+public:
+	CNameList();
+
+	// Cheap when pszList didn't change, returns true if it did
+	bool Set(const char *pszList);
+	bool Contains(const char *pszName) const;
+	int Count() const { return m_nNames; }
+
+private:
+	char m_szList[512];
+	int m_nNames;
+	char m_szNames[NAMELIST_MAX_NAMES][NAMELIST_NAME_LENGTH];
+};
+
+/**
+ * Detour logic below is kept free of SDK types so CSSFixes.bench can drive it
+ * with synthetic players and entities.
+ */
+
+enum KeyValueFix
+{
+	KeyValueFix_None = 0,
+	KeyValueFix_Angle,			// "angle" crashes the engine, rename it to "angles"
+	KeyValueFix_CTSpawn,		// classname info_player_terrorist -> info_player_counterterrorist
+	KeyValueFix_BuyzoneTeam,	// teamnum, forced to CT if the entity is a func_buyzone
+	KeyValueFix_AbsVelocity,	// absvelocity has to be written to m_vecAbsVelocity by hand
+};
+
+// Decides which DETOUR_KeyValue fix applies to a key, applies the ones that only rewrite strings
+KeyValueFix UTIL_FixKeyValue(const char **pszKeyName, const char **pszValue, bool bForceCTSpawn);
+
+// Returns true if the entity should be EFL_SERVER_ONLY, switches T spawnpoints to CT ones (sets pbForcedCT)
+bool UTIL_FixPostConstructor(const char **pszClassname, bool bForceCTSpawn, bool *pbForcedCT);
+
+enum EdictPressureAction
+{
+	EdictPressure_Allow = 0,
+	EdictPressure_ServerOnly,	// create it without an edict (EFL_SERVER_ONLY)
+	EdictPressure_Refuse,		// CreateEntityByName returns NULL
+};
+
+/**
+ * Edict pressure for spawns of non-critical classes. At or above the
+ * watermark only iBudget of them per tick still get an edict, the rest are
+ * made server only (mode 1) or refused (mode 2).
+ */
+class CEdictPressure
+{
+public:
+	CEdictPressure();
+
+	void Configure(int iMode, int iWatermark, int iBudget);
+	bool IsEnabled() const { return m_iMode > 0 && m_iWatermark > 0; }
+	EdictPressureAction Check(int iTick, int nEdicts);
+
+public:
+	uint64_t m_nAllowed;	// let through on the budget above the watermark
+	uint64_t m_nServerOnly;
+	uint64_t m_nRefused;
+
+private:
+	int m_iMode;
+	int m_iWatermark;
+	int m_iBudget;
+	int m_iTick;
+	int m_nTickSpawns;
+};
+
+#define PARKED_CLIENTS				66
+#define PARKED_THINKERS_PER_CLIENT	4
+
+/**
+ * Entities that stopped thinking until something about a client changes,
+ * e.g. a game_ui waiting for its player's buttons. Kept as entity
+ * references per client, PARKED_THINKERS_PER_CLIENT at most.
+ */
+class CParkedThinkers
+{
+public:
+	CParkedThinkers();
+
+	// Returns false if the client has no room left, the entity should keep thinking
+	bool Park(int iClient, uint32_t iRef);
+	bool Any() const { return m_nTotal > 0; }
+	int Count(int iClient) const { return m_nCount[iClient]; }
+
+	/**
+	 * Visit(uint32_t iRef) returns true once the entity is done waiting,
+	 * it's dropped from the client's list then. Returns the number dropped.
+	 */
+	template <typename F>
+	int Visit(int iClient, F Wake)
+	{
+		int nDropped = 0;
+		for(int i = 0; i < m_nCount[iClient]; )
+		{
+			if(Wake(m_Refs[iClient][i]))
+			{
+				m_Refs[iClient][i] = m_Refs[iClient][--m_nCount[iClient]];
+				m_nTotal--;
+				nDropped++;
+			}
+			else
+				i++;
+		}
+		return nDropped;
+	}
+
+	void Clear(int iClient);
+	void Clear();
+
+private:
+	uint32_t m_Refs[PARKED_CLIENTS][PARKED_THINKERS_PER_CLIENT];
+	int m_nCount[PARKED_CLIENTS];
+	int m_nTotal;
+};
+
+// filter_activator_context: passes if the context names match and the value is nonzero
+bool UTIL_ContextPasses(const char *szFilterContext, const char *szContext, const char *szValue);
+
+// Victims are bits of a uint64_t row of the pass through matrix
+#define PASSTHROUGH_MAXPLAYERS	64
+
+/**
+ * ShouldHitEntity decision for FireBullets/SwingOrStab traces.
+ * Returns true if the trace should pass through the entity at index.
+ *
+ * GetPlayer(int client, int *pTeam, char *pLifeState) fills in a player's
+ * team and life state, returns false if the client isn't valid.
+ */
+template <typename F>
+bool UTIL_BulletPassesThrough(int index, int iMaxPlayers, const char *pPhysboxToClientMap,
+	int iAttacker, int iAttackerTeam, const uint64_t *pPassThroughMatrix, F GetPlayer)
+{
+	int iTeam = 0;
+
+	if(index > iMaxPlayers && pPhysboxToClientMap && index < 2048)
+	{
+		index = pPhysboxToClientMap[index];
+	}
+
+	if(index >= -3 && index <= -1)
+	{
+		iTeam = -index;
+	}
+	else if(index < 1 || index > iMaxPlayers)
+	{
+		return false;
+	}
+	else if(index <= PASSTHROUGH_MAXPLAYERS && (pPassThroughMatrix[iAttacker] & (1ULL << (index - 1))))
+	{
+		return true;
+	}
+
+	char lifeState = 0;
+	if(!iTeam && !GetPlayer(index, &iTeam, &lifeState))
+		return false;
+
+	return iTeam == iAttackerTeam || lifeState != 0;
+}
+
+// Works on SendTable and anything else with the same GetName/GetNumProps/GetProp(i)->GetDataTable() shape
+template <typename T>
+bool UTIL_ContainsDataTable(T *pTable, const char *name)
+{
+	const char *pname = pTable->GetName();
+	int props = pTable->GetNumProps();
+	T *table;
+
+	if (pname && strcmp(name, pname) == 0)
+		return true;
+
+	for (int i=0; i<props; i++)
+	{
+		if ((table = pTable->GetProp(i)->GetDataTable()) != NULL)
+		{
+			pname = table->GetName();
+			if (pname && strcmp(name, pname) == 0)
+			{
+				return true;
+			}
+
+			if (UTIL_ContainsDataTable(table, name))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+#define DATATABLE_CACHE_CLASSES 1024
+
+// Memoizes UTIL_ContainsDataTable for one table name per server class id
+template <typename T>
+class CDataTableMembership
+{
+public:
+	CDataTableMembership(const char *pszTable) : m_pszTable(pszTable)
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		memset(m_State, 0, sizeof(m_State));
+	}
+
+	bool Contains(int iClassID, T *pTable)
+	{
+		if(iClassID < 0 || iClassID >= DATATABLE_CACHE_CLASSES)
+			return UTIL_ContainsDataTable(pTable, m_pszTable);
+
+		if(!m_State[iClassID])
+			m_State[iClassID] = UTIL_ContainsDataTable(pTable, m_pszTable) ? 1 : -1;
+
+		return m_State[iClassID] > 0;
+	}
+
+private:
+	const char *m_pszTable;
+	signed char m_State[DATATABLE_CACHE_CLASSES];	// 0 = unknown, 1 = contains, -1 = doesn't
+};
+
+#endif // _INCLUDE_CSSFIXES_UTILS_H_